@@ -0,0 +1,460 @@
+#include <eos/table/btree_index.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace eos { namespace table {
+
+   constexpr index_kind btree_index::kind;
+   constexpr uint16_t   btree_index::leaf_capacity;
+   constexpr uint16_t   btree_index::inner_capacity;
+
+   btree_index::const_iterator& btree_index::const_iterator::operator++()
+   {
+      if( ++pos >= leaf->count )
+      {
+         leaf = leaf->next;
+         pos  = 0;
+      }
+      return *this;
+   }
+
+   btree_index::const_iterator& btree_index::const_iterator::operator--()
+   {
+      if( leaf == nullptr )
+      {
+         leaf = tree->last_leaf;
+         pos  = leaf->count - 1;
+      }
+      else if( pos == 0 )
+      {
+         leaf = leaf->prev;
+         pos  = leaf->count - 1;
+      }
+      else
+         --pos;
+      return *this;
+   }
+
+   btree_index::btree_index(const types_manager::table_index& ti)
+      : program(ti), normalizer(ti), key_compare(ti, true), stats(ti), root(new leaf_node()), first_leaf(static_cast<leaf_node*>(root)), last_leaf(first_leaf)
+   {
+   }
+
+   btree_index::~btree_index()
+   {
+      destroy(root);
+   }
+
+   void btree_index::destroy(node* n)
+   {
+      if( n->leaf )
+      {
+         delete static_cast<leaf_node*>(n);
+         return;
+      }
+
+      auto in = static_cast<inner_node*>(n);
+      for( uint16_t i = 0; i < in->count; ++i )
+         destroy(in->children[i]);
+      delete in;
+   }
+
+   void btree_index::add_memory_usage(const node* n, index_memory_usage& u)const
+   {
+      ++u.nodes;
+      if( n->leaf )
+      {
+         u.node_bytes += sizeof(leaf_node);
+         return;
+      }
+
+      auto in = static_cast<const inner_node*>(n);
+      u.node_bytes += sizeof(inner_node);
+      for( const auto& s : in->separators ) // Unused separators may still hold the storage of keys moved out of them
+         u.key_bytes += s.data.capacity();
+      for( uint16_t i = 0; i < in->count; ++i )
+         add_memory_usage(in->children[i], u);
+   }
+
+   index_memory_usage btree_index::get_memory_usage()const
+   {
+      index_memory_usage u;
+      u.kind = kind;
+      add_memory_usage(root, u);
+      return u;
+   }
+
+   void btree_index::clear()
+   {
+      destroy(root);
+      root        = new leaf_node();
+      first_leaf  = static_cast<leaf_node*>(root);
+      last_leaf   = first_leaf;
+      num_objects = 0;
+   }
+
+   btree_index::probe btree_index::make_probe(const normalized_key& nk, const dynamic_object* obj,
+                                              int8_t (*compare_key)(const void*, const dynamic_object&), const void* lookup)
+   {
+      return probe{nk, key_prefix(nk), obj, compare_key, lookup};
+   }
+
+   int8_t btree_index::compare_entry(const leaf_node& leaf, uint16_t pos, const probe& p)const
+   {
+      auto c = key_prefix::compare(leaf.prefixes[pos], leaf.prefix_lengths[pos], p.prefix.value, p.prefix.length);
+      if( c != 0 )
+         return c;
+
+      const auto& o = *leaf.objects[pos];
+      if( p.obj != nullptr )
+      {
+         EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), false);
+         return program.compare_validated_objects(o.id, o.data, p.obj->id, p.obj->data);
+      }
+      return p.compare_key(p.lookup, o);
+   }
+
+   btree_index::const_iterator btree_index::normalize_position(const leaf_node* leaf, uint16_t pos)const
+   {
+      while( leaf != nullptr && pos >= leaf->count )
+      {
+         leaf = leaf->next;
+         pos  = 0;
+      }
+      return const_iterator(this, leaf, pos);
+   }
+
+   std::pair<btree_index::leaf_node*, uint16_t>
+   btree_index::descend(const probe& p, bool past_equal_separators, bool stop_at_equal_entries, path_type* path)const
+   {
+      node* n = root;
+      while( !n->leaf )
+      {
+         auto in = static_cast<inner_node*>(n);
+         uint16_t lo = 0, hi = in->count - 1;
+         while( lo < hi )
+         {
+            uint16_t mid = lo + (hi - lo) / 2;
+            auto c = normalized_key_compare::compare(in->separators[mid], p.key);
+            if( c < 0 || (past_equal_separators && c == 0) )
+               lo = mid + 1;
+            else
+               hi = mid;
+         }
+         if( path != nullptr )
+            path->emplace_back(in, lo);
+         n = in->children[lo];
+      }
+
+      auto leaf = static_cast<leaf_node*>(n);
+      uint16_t lo = 0, hi = leaf->count;
+      while( lo < hi )
+      {
+         uint16_t mid = lo + (hi - lo) / 2;
+         auto c = compare_entry(*leaf, mid, p);
+         if( c < 0 || (!stop_at_equal_entries && c == 0) )
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      return {leaf, lo};
+   }
+
+   const dynamic_object* btree_index::insert(const dynamic_object& o)
+   {
+      auto nk = normalizer(o);
+      auto p  = make_probe(nk, &o);
+
+      // Separators equal to o are passed so that an object equal to o (in a unique index) can only be in the leaf reached.
+      path_type path;
+      auto res  = descend(p, true, true, &path);
+      auto leaf = res.first;
+      auto pos  = res.second;
+      if( pos < leaf->count && compare_entry(*leaf, pos, p) == 0 )
+         return leaf->objects[pos];
+
+      leaf_node* right = nullptr;
+      if( leaf->count == leaf_capacity )
+      {
+         right = new leaf_node();
+         uint16_t half = leaf_capacity / 2;
+         std::copy(leaf->prefixes + half,       leaf->prefixes + leaf_capacity,       right->prefixes);
+         std::copy(leaf->objects + half,        leaf->objects + leaf_capacity,        right->objects);
+         std::copy(leaf->prefix_lengths + half, leaf->prefix_lengths + leaf_capacity, right->prefix_lengths);
+         right->count = leaf_capacity - half;
+         leaf->count  = half;
+
+         right->prev = leaf;
+         right->next = leaf->next;
+         if( leaf->next != nullptr )
+            leaf->next->prev = right;
+         else
+            last_leaf = right;
+         leaf->next = right;
+
+         if( pos > half )
+         {
+            leaf = right;
+            pos -= half;
+         }
+      }
+
+      std::copy_backward(leaf->prefixes + pos,       leaf->prefixes + leaf->count,       leaf->prefixes + leaf->count + 1);
+      std::copy_backward(leaf->objects + pos,        leaf->objects + leaf->count,        leaf->objects + leaf->count + 1);
+      std::copy_backward(leaf->prefix_lengths + pos, leaf->prefix_lengths + leaf->count, leaf->prefix_lengths + leaf->count + 1);
+      leaf->prefixes[pos]       = p.prefix.value;
+      leaf->prefix_lengths[pos] = p.prefix.length;
+      leaf->objects[pos]        = &o;
+      ++leaf->count;
+      ++num_objects;
+
+      if( right != nullptr )
+         insert_into_parent(path, normalizer(*right->objects[0]), right);
+
+      return nullptr;
+   }
+
+   void btree_index::bulk_load(sorted_run& run)
+   {
+      if( num_objects != 0 )
+         throw std::logic_error("Bulk loading requires an empty index");
+      if( run.empty() )
+         return;
+
+      destroy(root);
+
+      // Build the tree bottom-up, spreading the entries (and then the children of each level) evenly over as few nodes as possible.
+      // Each node is paired with the smallest key under it, which becomes the separator in front of it in its parent.
+      std::vector<std::pair<node*, normalized_key>> level;
+      size_t num_leaves = (run.size() + leaf_capacity - 1) / leaf_capacity;
+      leaf_node* prev = nullptr;
+      for( size_t i = 0, begin = 0; i < num_leaves; ++i )
+      {
+         size_t end = run.size() * (i + 1) / num_leaves;
+         auto leaf = new leaf_node();
+         for( size_t j = begin; j < end; ++j, ++leaf->count )
+         {
+            auto p = make_probe(run[j].first, run[j].second);
+            leaf->prefixes[leaf->count]       = p.prefix.value;
+            leaf->prefix_lengths[leaf->count] = p.prefix.length;
+            leaf->objects[leaf->count]        = run[j].second;
+         }
+
+         leaf->prev = prev;
+         if( prev != nullptr )
+            prev->next = leaf;
+         else
+            first_leaf = leaf;
+         prev = leaf;
+
+         level.emplace_back(leaf, std::move(run[begin].first));
+         begin = end;
+      }
+      last_leaf = prev;
+
+      while( level.size() > 1 )
+      {
+         std::vector<std::pair<node*, normalized_key>> parents;
+         size_t num_parents = (level.size() + inner_capacity - 1) / inner_capacity;
+         for( size_t i = 0, begin = 0; i < num_parents; ++i )
+         {
+            size_t end = level.size() * (i + 1) / num_parents;
+            auto in = new inner_node();
+            for( size_t j = begin; j < end; ++j, ++in->count )
+            {
+               in->children[in->count] = level[j].first;
+               if( j > begin )
+                  in->separators[in->count - 1] = std::move(level[j].second);
+            }
+            parents.emplace_back(in, std::move(level[begin].second));
+            begin = end;
+         }
+         level = std::move(parents);
+      }
+
+      root        = level.front().first;
+      num_objects = run.size();
+   }
+
+   void btree_index::insert_into_parent(path_type& path, normalized_key separator, node* right)
+   {
+      if( path.empty() )
+      {
+         auto new_root = new inner_node();
+         new_root->children[0]   = root;
+         new_root->children[1]   = right;
+         new_root->separators[0] = std::move(separator);
+         new_root->count         = 2;
+         root = new_root;
+         return;
+      }
+
+      auto parent = path.back().first;
+      auto idx    = path.back().second;
+      path.pop_back();
+
+      if( parent->count < inner_capacity )
+      {
+         std::move_backward(parent->separators + idx, parent->separators + parent->count - 1, parent->separators + parent->count);
+         std::copy_backward(parent->children + idx + 1, parent->children + parent->count, parent->children + parent->count + 1);
+         parent->separators[idx]   = std::move(separator);
+         parent->children[idx + 1] = right;
+         ++parent->count;
+         return;
+      }
+
+      std::vector<normalized_key> separators;
+      std::vector<node*>          children;
+      separators.reserve(inner_capacity);
+      children.reserve(inner_capacity + 1);
+      for( uint16_t i = 0; i < inner_capacity - 1; ++i )
+      {
+         if( i == idx )
+            separators.push_back(std::move(separator));
+         separators.push_back(std::move(parent->separators[i]));
+      }
+      if( idx == inner_capacity - 1 )
+         separators.push_back(std::move(separator));
+      for( uint16_t i = 0; i < inner_capacity; ++i )
+      {
+         children.push_back(parent->children[i]);
+         if( i == idx )
+            children.push_back(right);
+      }
+
+      // The left node keeps the first half of the children; the separator between the halves moves up to the grandparent.
+      uint16_t left_count = (inner_capacity + 1) / 2;
+      auto new_inner = new inner_node();
+      for( uint16_t i = 0; i < left_count; ++i )
+         parent->children[i] = children[i];
+      for( uint16_t i = 0; i + 1 < left_count; ++i )
+         parent->separators[i] = std::move(separators[i]);
+      for( uint16_t i = left_count - 1; i < inner_capacity - 1; ++i )
+         parent->separators[i] = normalized_key();
+      parent->count = left_count;
+
+      new_inner->count = static_cast<uint16_t>(children.size() - left_count);
+      for( uint16_t i = 0; i < new_inner->count; ++i )
+         new_inner->children[i] = children[left_count + i];
+      for( uint16_t i = 0; i + 1 < new_inner->count; ++i )
+         new_inner->separators[i] = std::move(separators[left_count + i]);
+
+      insert_into_parent(path, std::move(separators[left_count - 1]), new_inner);
+   }
+
+   void btree_index::erase(const dynamic_object& o)
+   {
+      auto nk = normalizer(o);
+      auto p  = make_probe(nk, &o);
+
+      path_type path;
+      auto res  = descend(p, true, true, &path);
+      auto leaf = res.first;
+      auto pos  = res.second;
+      if( pos >= leaf->count || leaf->objects[pos] != &o )
+         return;
+
+      std::copy(leaf->prefixes + pos + 1,       leaf->prefixes + leaf->count,       leaf->prefixes + pos);
+      std::copy(leaf->objects + pos + 1,        leaf->objects + leaf->count,        leaf->objects + pos);
+      std::copy(leaf->prefix_lengths + pos + 1, leaf->prefix_lengths + leaf->count, leaf->prefix_lengths + pos);
+      --leaf->count;
+      --num_objects;
+
+      if( leaf->count == 0 && leaf != root )
+         remove_leaf(path, leaf);
+   }
+
+   void btree_index::remove_leaf(path_type& path, leaf_node* leaf)
+   {
+      if( leaf->prev != nullptr )
+         leaf->prev->next = leaf->next;
+      else
+         first_leaf = leaf->next;
+      if( leaf->next != nullptr )
+         leaf->next->prev = leaf->prev;
+      else
+         last_leaf = leaf->prev;
+      delete leaf;
+
+      // Remove the emptied node from its parent, and keep going up while that leaves the parent without children.
+      while( !path.empty() )
+      {
+         auto parent = path.back().first;
+         auto idx    = path.back().second;
+         path.pop_back();
+
+         uint16_t sep = (idx > 0) ? idx - 1 : 0;
+         if( parent->count > 1 )
+         {
+            std::move(parent->separators + sep + 1, parent->separators + parent->count - 1, parent->separators + sep);
+            parent->separators[parent->count - 2] = normalized_key();
+         }
+         std::copy(parent->children + idx + 1, parent->children + parent->count, parent->children + idx);
+         --parent->count;
+
+         if( parent->count > 0 )
+            break;
+         delete parent;
+      }
+
+      while( !root->leaf && root->count == 1 )
+      {
+         auto in = static_cast<inner_node*>(root);
+         root = in->children[0];
+         delete in;
+      }
+   }
+
+   btree_index::const_iterator btree_index::iterator_to(const dynamic_object& o)const
+   {
+      auto nk = normalizer(o);
+      auto p  = make_probe(nk, &o);
+
+      auto res = descend(p, true, true, nullptr);
+      if( res.second >= res.first->count || res.first->objects[res.second] != &o )
+         return end();
+      return const_iterator(this, res.first, res.second);
+   }
+
+   bound_key btree_index::bind(const dynamic_key& k)const
+   {
+      auto b = key_compare.bind(k);
+      b.normalized = normalizer(k);
+      return b;
+   }
+
+   btree_index::const_iterator btree_index::lower_bound(const probe& p)const
+   {
+      auto res = descend(p, false, true, nullptr);
+      return normalize_position(res.first, res.second);
+   }
+
+   btree_index::const_iterator btree_index::upper_bound(const probe& p)const
+   {
+      auto res = descend(p, true, false, nullptr);
+      return normalize_position(res.first, res.second);
+   }
+
+   btree_index::const_iterator btree_index::lower_bound(const bound_key& k)const
+   {
+      key_lookup<bound_key_compare, bound_key> l{key_compare, k};
+      return lower_bound(make_probe(k.normalized, nullptr, &l.compare, &l));
+   }
+
+   btree_index::const_iterator btree_index::upper_bound(const bound_key& k)const
+   {
+      key_lookup<bound_key_compare, bound_key> l{key_compare, k};
+      return upper_bound(make_probe(k.normalized, nullptr, &l.compare, &l));
+   }
+
+   btree_index::const_iterator btree_index::find(const bound_key& k)const
+   {
+      auto itr = lower_bound(k);
+      if( itr == end() || key_compare.compare(*itr, k) != 0 )
+         return end();
+      return itr;
+   }
+
+} }
+
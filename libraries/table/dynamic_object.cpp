@@ -1,28 +1,123 @@
 #include <eos/table/dynamic_object.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <boost/functional/hash.hpp>
+
 namespace eos { namespace table {
 
    bool dynamic_object_compare::operator()(const dynamic_object& lhs, const dynamic_object& rhs)const
    {
-      const auto& tm = ti.get_types_manager();
-      auto c = tm.compare_objects(lhs.id, lhs.data, rhs.id, rhs.data, ti); 
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), false);
+      auto c = ( trusted ? program.compare_validated_objects(lhs.id, lhs.data, rhs.id, rhs.data)
+                         : program.compare_objects(lhs.id, lhs.data, rhs.id, rhs.data) );
       return (c < 0);
    }
 
    bool dynamic_key_compare::operator()(const dynamic_object& lhs, const dynamic_key& rhs)const
    {
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), true);
       const auto& tm = ti.get_types_manager();
-      auto c = tm.compare_object_with_key(lhs.data, rhs.data, ti); 
+      auto c = tm.compare_object_with_key(lhs.data, rhs.data, ti, rhs.num_members); 
       return (c < 0);
    }
 
    bool dynamic_key_compare::operator()(const dynamic_key& lhs, const dynamic_object& rhs)const
    {
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), true);
       const auto& tm = ti.get_types_manager();
-      auto c = tm.compare_object_with_key(rhs.data, lhs.data, ti); 
+      auto c = tm.compare_object_with_key(rhs.data, lhs.data, ti, lhs.num_members); 
       return (c > 0);
    }
 
+   bound_key_compare::bound_key_compare(const types_manager::table_index& ti, bool trusted)
+      : object_program(ti), key_program(ti, compare_program::key_view), trusted(trusted), stats(ti)
+   {
+      key_bases = object_program.get_key_bases(key_program);
+   }
 
-} }
+   bound_key bound_key_compare::bind(const dynamic_key& k)const
+   {
+      if( !key_program.validate(k.data, k.num_members) )
+         throw std::invalid_argument("Key data is malformed for the key of the index");
+      return bound_key(k, object_program.get_members_end(k.num_members));
+   }
+
+   int8_t bound_key_compare::compare(const dynamic_object& o, const bound_key& k)const
+   {
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), true);
+      return ( trusted ? object_program.compare_validated_object_with_key(o.data, k.data, key_bases, k.end)
+                       : object_program.compare_object_with_key(o.data, k.data, key_bases, k.end) );
+   }
 
+   int normalized_key_compare::compare(const normalized_key& lhs, const normalized_key& rhs)
+   {
+      auto n = std::min(lhs.data.size(), rhs.data.size());
+      if( n == 0 )
+         return 0;
+      return std::memcmp(lhs.data.data(), rhs.data.data(), n);
+   }
+
+   key_prefix::key_prefix(const normalized_key& k)
+      : length(static_cast<uint8_t>(std::min<size_t>(k.data.size(), sizeof(uint64_t))))
+   {
+      for( size_t i = 0; i < sizeof(uint64_t); ++i )
+         value = (value << 8) | (i < length ? static_cast<uint8_t>(k.data[i]) : 0);
+   }
+
+   normalized_key key_normalizer::operator()(const dynamic_object& o)const
+   {
+      normalized_key k;
+      object_program.normalize(o.data, k.data);
+      if( !object_program.is_unique() )
+      {
+         for( int shift = 56; shift >= 0; shift -= 8 )
+            k.data.push_back(static_cast<byte>(o.id >> shift));
+      }
+      return k;
+   }
+
+   normalized_key key_normalizer::operator()(const dynamic_key& k)const
+   {
+      normalized_key nk;
+      key_program.normalize(k.data, nk.data, k.num_members);
+      return nk;
+   }
+
+   uint32_t key_normalizer::get_object_key_size()const
+   {
+      auto size = object_program.get_normalized_size();
+      if( size == 0 || object_program.is_unique() )
+         return size;
+      return size + sizeof(uint64_t);
+   }
+
+   size_t dynamic_object_hash::operator()(const dynamic_object& o)const
+   {
+      auto nk = normalizer(o);
+      return boost::hash_range(nk.data.begin(), nk.data.end());
+   }
+
+   size_t dynamic_object_hash::operator()(const dynamic_key& k)const
+   {
+      auto nk = normalizer(k);
+      return boost::hash_range(nk.data.begin(), nk.data.end());
+   }
+
+   bool dynamic_object_equal::operator()(const dynamic_object& lhs, const dynamic_object& rhs)const
+   {
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), false);
+      auto c = ( trusted ? program.compare_validated_objects(lhs.id, lhs.data, rhs.id, rhs.data)
+                         : program.compare_objects(lhs.id, lhs.data, rhs.id, rhs.data) );
+      return (c == 0);
+   }
+
+   bool dynamic_object_equal::operator()(const dynamic_key& lhs, const dynamic_object& rhs)const
+   {
+      EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), true);
+      const auto& tm = ti.get_types_manager();
+      return (tm.compare_object_with_key(rhs.data, lhs.data, ti) == 0);
+   }
+
+} }
@@ -0,0 +1,715 @@
+#include <eos/table/dynamic_table.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <numeric>
+#include <ostream>
+#include <thread>
+
+namespace eos { namespace table {
+
+   namespace {
+
+      // Calls f(i) for every i in [0, n), spread over up to one thread per core (fewer, down to the calling thread alone, if threads cannot
+      // be spawned). Rethrows the first exception thrown by f, if any.
+      template<typename F>
+      void for_each_in_parallel(size_t n, F f)
+      {
+         size_t num_workers = std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+         std::vector<std::exception_ptr> errors(num_workers);
+         auto work = [&](size_t w)
+         {
+            try
+            {
+               for( size_t i = w; i < n; i += num_workers )
+                  f(i);
+            }
+            catch( ... )
+            {
+               errors[w] = std::current_exception();
+            }
+         };
+
+         // If a thread cannot be spawned (e.g. when the process is at its limit of threads), the calling thread takes over the share of every
+         // worker not yet spawned, so the work degrades to serial execution rather than escaping while spawned threads still refer to it.
+         std::vector<std::thread> workers;
+         workers.reserve(num_workers);
+         try
+         {
+            for( size_t w = 1; w < num_workers; ++w )
+               workers.emplace_back(work, w);
+         }
+         catch( ... )
+         {
+            // The workers not spawned are run below
+         }
+         for( size_t w = 1 + workers.size(); w < num_workers; ++w )
+            work(w);
+         if( num_workers > 0 )
+            work(0);
+         for( auto& t : workers )
+            t.join();
+
+         for( const auto& e : errors )
+            if( e )
+               std::rethrow_exception(e);
+      }
+
+      // Positions (in id order) of the objects of the table, in the order of index.
+      template<class Index>
+      std::vector<uint64_t> order_of(const Index& index, const std::unordered_map<const dynamic_object*, uint64_t>& positions)
+      {
+         std::vector<uint64_t> order;
+         order.reserve(index.size());
+         for( const auto& o : index )
+            order.push_back(positions.at(&o));
+         return order;
+      }
+
+   }
+
+   dynamic_table::dynamic_table(const types_manager& tm, type_id::index_t tbl_indx, index_kind ordered_index_kind)
+      : tm(tm), tbl_indx(tbl_indx), objects(object_container::ctor_args_list(), counting_allocator<dynamic_object>(&object_bytes))
+   {
+      if( ordered_index_kind != index_kind::ordered && ordered_index_kind != index_kind::btree )
+         throw std::invalid_argument("Not an engine for ordered indices");
+
+      auto num_indices = tm.get_num_indices_in_table(tbl_indx);
+      indices.reserve(num_indices);
+      key_layouts.reserve(num_indices);
+      for( uint8_t i = 0; i < num_indices; ++i )
+      {
+         auto ti = tm.get_table_index(tbl_indx, i);
+         key_layouts.emplace_back(ti);
+         if( ti.is_hashed() )
+            indices.emplace_back(new hashed_index(ti));
+         else if( ordered_index_kind == index_kind::btree )
+            indices.emplace_back(new btree_index(ti));
+         else
+            indices.emplace_back(new ordered_index(ti));
+      }
+   }
+
+   const dynamic_object* dynamic_table::add_to_indices(const dynamic_object& o)
+   {
+      for( auto itr = indices.begin(); itr != indices.end(); ++itr )
+      {
+         auto conflict = (*itr)->insert(o);
+         if( conflict == nullptr )
+            continue;
+
+         while( itr != indices.begin() )
+         {
+            --itr;
+            (*itr)->erase(o);
+         }
+         return conflict;
+      }
+      return nullptr;
+   }
+
+   void dynamic_table::remove_from_indices(const dynamic_object& o)
+   {
+      for( auto& index : indices )
+         index->erase(o);
+   }
+
+   void dynamic_table::validate(const raw_region& data)const
+   {
+      for( const auto& layout : key_layouts )
+      {
+         if( !layout.validate(data) )
+            throw std::invalid_argument("Object data is malformed for the keys of the table");
+      }
+   }
+
+   void dynamic_table::adopt(raw_region& data)
+   {
+      if( !data.is_inline() && !data.is_shared() && data.get_memory_resource() != &payloads )
+         data = raw_region(data, &payloads);
+   }
+
+   std::pair<dynamic_table::const_iterator, bool> dynamic_table::insert(dynamic_object o)
+   {
+      validate(o.data);
+      adopt(o.data);
+
+      auto res = objects.insert(std::move(o));
+      if( !res.second )
+         return res;
+
+      auto conflict = add_to_indices(*res.first);
+      if( conflict == nullptr )
+      {
+         on_insert(res.first->id);
+         return res;
+      }
+
+      auto conflict_id = conflict->id;
+      objects.erase(res.first);
+      return {objects.find(conflict_id), false};
+   }
+
+   bool dynamic_table::modify(const_iterator itr, raw_region new_data)
+   {
+      validate(new_data);
+      adopt(new_data);
+
+      // The indices order objects by their data, so the object must be out of all of them while its data changes.
+      remove_from_indices(*itr);
+      objects.modify(itr, [&](dynamic_object& o) { std::swap(o.data, new_data); });
+
+      if( add_to_indices(*itr) == nullptr )
+      {
+         on_modify(itr->id, new_data);
+         return true;
+      }
+
+      objects.modify(itr, [&](dynamic_object& o) { std::swap(o.data, new_data); });
+      add_to_indices(*itr); // Cannot fail since the object was in all indices with this data before.
+      return false;
+   }
+
+   std::vector<dynamic_table::bulk_load_rejection> dynamic_table::bulk_load(std::vector<dynamic_object>& batch)
+   {
+      if( !empty() )
+         throw std::logic_error("Bulk loading requires an empty table");
+
+      for( const auto& o : batch )
+         validate(o.data);
+
+      std::vector<bulk_load_rejection> rejections;
+
+      std::vector<size_t> by_id(batch.size());
+      std::iota(by_id.begin(), by_id.end(), 0);
+      std::stable_sort(by_id.begin(), by_id.end(), [&](size_t lhs, size_t rhs) { return batch[lhs].id < batch[rhs].id; });
+      for( size_t i = 1; i < by_id.size(); ++i )
+      {
+         if( batch[by_id[i]].id == batch[by_id[i-1]].id )
+            rejections.push_back({by_id[i], -1});
+      }
+
+      // Sort the normalized keys of every index, breaking ties by position in the batch so that the first of equal keys is the earliest one.
+      std::vector<sorted_run> runs(indices.size());
+      std::vector<std::vector<bulk_load_rejection>> index_rejections(indices.size());
+      for_each_in_parallel(indices.size(), [&](size_t i)
+      {
+         auto ti = tm.get_table_index(tbl_indx, static_cast<uint8_t>(i));
+         key_normalizer normalizer(ti);
+
+         auto& run = runs[i];
+         run.reserve(batch.size());
+         for( const auto& o : batch )
+            run.emplace_back(normalizer(o), &o);
+         std::sort(run.begin(), run.end(), [](const sorted_run::value_type& lhs, const sorted_run::value_type& rhs)
+         {
+            auto c = normalized_key_compare::compare(lhs.first, rhs.first);
+            return (c != 0) ? (c < 0) : (lhs.second < rhs.second);
+         });
+
+         if( !ti.is_unique() )
+            return;
+         for( size_t j = 1; j < run.size(); ++j )
+         {
+            if( normalized_key_compare::compare(run[j-1].first, run[j].first) == 0 )
+               index_rejections[i].push_back({static_cast<size_t>(run[j].second - batch.data()), static_cast<int16_t>(i)});
+         }
+      });
+
+      for( const auto& r : index_rejections )
+         rejections.insert(rejections.end(), r.begin(), r.end());
+      std::sort(rejections.begin(), rejections.end(), [](const bulk_load_rejection& lhs, const bulk_load_rejection& rhs)
+      {
+         return (lhs.position != rhs.position) ? (lhs.position < rhs.position) : (lhs.index_seq_num < rhs.index_seq_num);
+      });
+      rejections.erase(std::unique(rejections.begin(), rejections.end(), [](const bulk_load_rejection& lhs, const bulk_load_rejection& rhs)
+      {
+         return lhs.position == rhs.position;
+      }), rejections.end());
+
+      std::vector<bool> rejected(batch.size(), false);
+      for( const auto& r : rejections )
+         rejected[r.position] = true;
+
+      // Objects are added in id order, so each insertion into the id index is amortized constant time.
+      std::vector<const dynamic_object*> stored(batch.size(), nullptr);
+      for( auto pos : by_id )
+      {
+         if( rejected[pos] )
+            continue;
+         adopt(batch[pos].data);
+         stored[pos] = &*objects.insert(objects.end(), std::move(batch[pos]));
+      }
+
+      try
+      {
+         for_each_in_parallel(indices.size(), [&](size_t i)
+         {
+            auto& run = runs[i];
+            size_t n = 0;
+            for( auto& p : run )
+            {
+               auto pos = static_cast<size_t>(p.second - batch.data());
+               if( rejected[pos] )
+                  continue;
+               if( &run[n] != &p )
+                  run[n].first = std::move(p.first);
+               run[n].second = stored[pos];
+               ++n;
+            }
+            run.resize(n);
+            indices[i]->bulk_load(run);
+         });
+      }
+      catch( ... )
+      {
+         // Nothing has been recorded for undo yet, so the table is emptied without going through clear (which would record the
+         // objects as removed by the active session, if any).
+         for( auto& index : indices )
+            index->clear();
+         objects.clear();
+         throw;
+      }
+
+      for( auto o : stored )
+      {
+         if( o != nullptr )
+            on_insert(o->id);
+      }
+
+      return rejections;
+   }
+
+   void dynamic_table::save(const std::string& path, bool keep_orders)const
+   {
+      std::vector<const dynamic_object*> stored;
+      std::unordered_map<const dynamic_object*, uint64_t> positions;
+      stored.reserve(size());
+      if( keep_orders )
+         positions.reserve(size());
+      for( const auto& o : objects )
+      {
+         if( keep_orders )
+            positions.emplace(&o, stored.size());
+         stored.push_back(&o);
+      }
+
+      std::vector<table_image::index_info> infos;
+      for( uint8_t i = 0; i < indices.size(); ++i )
+         infos.push_back(table_image::index_info::describe(tm.get_table_index(tbl_indx, i)));
+
+      std::vector<std::vector<uint64_t>> orders(indices.size());
+      if( keep_orders )
+      {
+         for_each_in_parallel(indices.size(), [&](size_t i)
+         {
+            switch( indices[i]->get_kind() )
+            {
+               case index_kind::ordered:
+                  orders[i] = order_of(static_cast<const ordered_index&>(*indices[i]), positions);
+                  break;
+               case index_kind::btree:
+                  orders[i] = order_of(static_cast<const btree_index&>(*indices[i]), positions);
+                  break;
+               case index_kind::hashed:
+                  break; // Rebuilt by inserting the objects, since the order of a hash table is of no use to another one.
+            }
+         });
+      }
+
+      table_image::write(path, tm.get_fingerprint(), tbl_indx, infos, stored, orders);
+   }
+
+   void dynamic_table::load(const std::string& path)
+   {
+      if( !empty() )
+         throw std::logic_error("Loading an image requires an empty table");
+
+      table_image image(path);
+      if( image.get_table() != tbl_indx || image.get_fingerprint() != tm.get_fingerprint() )
+         throw std::runtime_error("Table image was saved for another definition of the table");
+      if( image.get_num_indices() != indices.size() )
+         throw std::runtime_error("Table image is malformed");
+      for( uint8_t i = 0; i < indices.size(); ++i )
+      {
+         if( !image.get_index_info(i).matches(tm.get_table_index(tbl_indx, i)) )
+            throw std::runtime_error("Index of the table image does not match the index of the table");
+      }
+
+      // The data is copied out of the image (into payloads, which only one thread may use) before being validated in parallel.
+      std::vector<dynamic_object> batch(image.size());
+      for( uint64_t pos = 0; pos < image.size(); ++pos )
+      {
+         auto v = image.get_object(pos);
+         if( pos > 0 && v.id <= batch[pos-1].id )
+            throw std::runtime_error("Objects of the table image are not in id order");
+
+         batch[pos].id   = v.id;
+         batch[pos].data = raw_region(&payloads);
+         batch[pos].data.assign(v.data, v.size);
+      }
+      for_each_in_parallel(batch.size(), [&](size_t pos) { validate(batch[pos].data); });
+
+      std::vector<const dynamic_object*> stored;
+      stored.reserve(batch.size());
+      for( auto& o : batch )
+         stored.push_back(&*objects.insert(objects.end(), std::move(o)));
+
+      try
+      {
+         for_each_in_parallel(indices.size(), [&](size_t i)
+         {
+            auto& index = *indices[i];
+            auto  ti    = tm.get_table_index(tbl_indx, static_cast<uint8_t>(i));
+            if( ti.is_hashed() )
+            {
+               for( auto o : stored )
+               {
+                  if( index.insert(*o) != nullptr )
+                     throw std::runtime_error("Objects of the table image violate a unique index");
+               }
+               return;
+            }
+
+            key_normalizer normalizer(ti);
+            sorted_run run;
+            run.reserve(stored.size());
+            if( auto order = image.get_order(static_cast<uint8_t>(i)) )
+            {
+               for( size_t j = 0; j < stored.size(); ++j )
+               {
+                  if( order[j] >= stored.size() )
+                     throw std::runtime_error("Table image is malformed");
+                  run.emplace_back(normalizer(*stored[order[j]]), stored[order[j]]);
+               }
+            }
+            else
+            {
+               for( auto o : stored )
+                  run.emplace_back(normalizer(*o), o);
+               std::sort(run.begin(), run.end(), [](const sorted_run::value_type& lhs, const sorted_run::value_type& rhs)
+               {
+                  return normalized_key_compare::compare(lhs.first, rhs.first) < 0;
+               });
+            }
+
+            // Normalized keys are distinct within an index (those of non-unique indices end with the id), so the run must be strictly
+            // increasing. This catches both a saved order that disagrees with the keys and duplicate keys in a unique index.
+            for( size_t j = 1; j < run.size(); ++j )
+            {
+               if( normalized_key_compare::compare(run[j-1].first, run[j].first) >= 0 )
+                  throw std::runtime_error("Objects of the table image are not ordered or violate a unique index");
+            }
+            index.bulk_load(run);
+         });
+      }
+      catch( ... )
+      {
+         // As in bulk_load, nothing has been recorded for undo yet, so the table is emptied without going through clear.
+         for( auto& index : indices )
+            index->clear();
+         objects.clear();
+         throw;
+      }
+
+      for( auto o : stored )
+         on_insert(o->id);
+   }
+
+   dynamic_table::const_iterator dynamic_table::erase(const_iterator itr)
+   {
+      remove_from_indices(*itr);
+      on_remove(itr);
+      return objects.erase(itr);
+   }
+
+   size_t dynamic_table::erase(uint64_t id)
+   {
+      auto itr = objects.find(id);
+      if( itr == objects.end() )
+         return 0;
+      erase(itr);
+      return 1;
+   }
+
+   void dynamic_table::clear()
+   {
+      for( auto& index : indices )
+         index->clear();
+      if( !undo_stack.empty() )
+      {
+         for( auto itr = objects.begin(); itr != objects.end(); ++itr )
+            on_remove(itr);
+      }
+      objects.clear();
+   }
+
+   dynamic_table::session::session(session&& other)
+      : table(other.table), apply(other.apply)
+   {
+      other.apply = false;
+   }
+
+   dynamic_table::session& dynamic_table::session::operator=(session&& other)
+   {
+      if( this != &other )
+      {
+         undo();
+         table = other.table;
+         apply = other.apply;
+         other.apply = false;
+      }
+      return *this;
+   }
+
+   dynamic_table::session::~session()
+   {
+      undo();
+   }
+
+   void dynamic_table::session::push()
+   {
+      apply = false;
+   }
+
+   void dynamic_table::session::squash()
+   {
+      if( apply )
+         table->squash();
+      apply = false;
+   }
+
+   void dynamic_table::session::undo()
+   {
+      if( apply )
+         table->undo();
+      apply = false;
+   }
+
+   dynamic_table::session dynamic_table::start_undo_session(bool enabled)
+   {
+      if( !enabled )
+         return session(*this, false);
+
+      undo_stack.emplace_back();
+      return session(*this, true);
+   }
+
+   void dynamic_table::on_insert(uint64_t id)
+   {
+      if( undo_stack.empty() )
+         return;
+
+      undo_stack.back().new_ids.insert(id);
+   }
+
+   void dynamic_table::on_modify(uint64_t id, raw_region& old_data)
+   {
+      if( undo_stack.empty() )
+         return;
+
+      auto& head = undo_stack.back();
+      if( head.new_ids.count(id) > 0 || head.old_values.count(id) > 0 )
+         return; // What was there before the session is already known.
+
+      head.old_values.emplace(id, std::move(old_data));
+   }
+
+   void dynamic_table::on_remove(const_iterator itr)
+   {
+      if( undo_stack.empty() )
+         return;
+
+      auto& head = undo_stack.back();
+      auto  id   = itr->id;
+      if( head.new_ids.erase(id) > 0 )
+         return;
+
+      auto old = head.old_values.find(id);
+      if( old != head.old_values.end() )
+      {
+         head.removed_values.emplace(id, std::move(old->second));
+         head.old_values.erase(old);
+         return;
+      }
+
+      raw_region data;
+      objects.modify(itr, [&](dynamic_object& o) { std::swap(o.data, data); });
+      head.removed_values.emplace(id, std::move(data));
+   }
+
+   void dynamic_table::undo()
+   {
+      if( undo_stack.empty() )
+         return;
+
+      auto& head = undo_stack.back();
+
+      for( auto id : head.new_ids )
+      {
+         auto itr = objects.find(id);
+         remove_from_indices(*itr);
+         objects.erase(itr);
+      }
+
+      // All modified objects leave the indices before any of them gets its old data back, since their new keys may collide with each other's old keys.
+      std::vector<const_iterator> restored;
+      restored.reserve(head.old_values.size());
+      for( auto& p : head.old_values )
+      {
+         auto itr = objects.find(p.first);
+         remove_from_indices(*itr);
+         objects.modify(itr, [&](dynamic_object& o) { std::swap(o.data, p.second); });
+         restored.push_back(itr);
+      }
+      for( auto itr : restored )
+      {
+         if( add_to_indices(*itr) != nullptr )
+            throw std::logic_error("Invariant failure: restoring the data of a modified object violates a unique index.");
+      }
+
+      for( auto& p : head.removed_values )
+      {
+         dynamic_object o;
+         o.id   = p.first;
+         o.data = std::move(p.second);
+         auto res = objects.insert(std::move(o));
+         if( !res.second || add_to_indices(*res.first) != nullptr )
+            throw std::logic_error("Invariant failure: restoring a removed object violates a unique index.");
+      }
+
+      undo_stack.pop_back();
+   }
+
+   void dynamic_table::squash()
+   {
+      if( undo_stack.empty() )
+         return;
+
+      if( undo_stack.size() == 1 )
+      {
+         undo_stack.pop_back();
+         return;
+      }
+
+      auto& state = undo_stack.back();
+      auto& prev  = undo_stack[undo_stack.size() - 2];
+
+      for( auto& p : state.old_values )
+      {
+         if( prev.new_ids.count(p.first) > 0 || prev.old_values.count(p.first) > 0 )
+            continue;
+         prev.old_values.emplace(p.first, std::move(p.second));
+      }
+
+      for( auto& p : state.removed_values )
+      {
+         if( prev.new_ids.erase(p.first) > 0 )
+            continue;
+
+         auto old = prev.old_values.find(p.first);
+         if( old != prev.old_values.end() )
+         {
+            prev.removed_values.emplace(p.first, std::move(old->second));
+            prev.old_values.erase(old);
+            continue;
+         }
+
+         prev.removed_values.emplace(p.first, std::move(p.second));
+      }
+
+      // After the removals, since an object removed and then inserted again during the session is in both.
+      for( auto id : state.new_ids )
+         prev.new_ids.insert(id);
+
+      undo_stack.pop_back();
+   }
+
+   void dynamic_table::commit()
+   {
+      undo_stack.clear();
+   }
+
+   table_memory_usage dynamic_table::get_memory_usage()const
+   {
+      table_memory_usage u;
+      for( const auto& o : objects )
+         u.count_object(o.data);
+      for( const auto& state : undo_stack )
+      {
+         for( const auto& p : state.old_values )
+            u.count_undo_data(p.second);
+         for( const auto& p : state.removed_values )
+            u.count_undo_data(p.second);
+      }
+      u.payload_blocks.used     = payloads.get_bytes_in_use();
+      u.payload_blocks.reserved = payloads.get_bytes_reserved();
+      u.object_bytes            = object_bytes;
+      for( const auto& index : indices )
+         u.indices.push_back(index->get_memory_usage());
+      return u;
+   }
+
+   void table_memory_usage::count_object(const raw_region& data)
+   {
+      ++num_objects;
+      if( data.is_inline() )
+      {
+         inline_payload_bytes += data.offset_end();
+         return;
+      }
+      if( data.is_shared() )
+      {
+         shared_payloads.used     += data.offset_end();
+         shared_payloads.reserved += raw_region::shared_header_size + data.offset_end();
+         return;
+      }
+      payloads.used     += data.offset_end();
+      payloads.reserved += data.capacity();
+   }
+
+   void table_memory_usage::count_undo_data(const raw_region& data)
+   {
+      if( data.is_inline() || data.is_shared() )
+         return; // Within the node of the undo_state holding it, or shared with the objects or their readers
+      undo_payloads.used     += data.offset_end();
+      undo_payloads.reserved += data.capacity();
+   }
+
+   uint64_t table_memory_usage::get_total()const
+   {
+      uint64_t total = object_bytes + payload_blocks.reserved + shared_payloads.reserved;
+      for( const auto& index : indices )
+         total += index.get_total();
+      return total;
+   }
+
+   void table_memory_usage::print(std::ostream& os)const
+   {
+      static const char* const kind_names[] = { "ordered", "btree", "hashed" };
+
+      os << "table of " << num_objects << " objects: " << get_total() << " bytes" << std::endl;
+      os << "   objects: " << object_bytes << " bytes, " << inline_payload_bytes << " of them inline data" << std::endl;
+      os << "   payloads: " << payloads.used << " bytes used, " << payloads.reserved << " reserved (" << payloads.get_slack() << " slack)" << std::endl;
+      if( shared_payloads.reserved > 0 )
+         os << "   shared payloads: " << shared_payloads.used << " bytes used, " << shared_payloads.reserved << " reserved" << std::endl;
+      if( undo_payloads.reserved > 0 )
+         os << "   undo payloads: " << undo_payloads.used << " bytes used, " << undo_payloads.reserved << " reserved" << std::endl;
+      os << "   payload blocks: " << payload_blocks.used << " bytes in use, " << payload_blocks.reserved << " reserved" << std::endl;
+      for( size_t i = 0; i < indices.size(); ++i )
+      {
+         const auto& index = indices[i];
+         os << "   index " << i << " (" << kind_names[static_cast<uint8_t>(index.kind)] << "): " << index.nodes << " nodes, "
+            << index.node_bytes << " node bytes, " << index.key_bytes << " key bytes" << std::endl;
+      }
+   }
+
+   const secondary_index& dynamic_table::get_index(uint8_t index_seq_num)const
+   {
+      if( index_seq_num >= indices.size() )
+         throw std::out_of_range("Table does not have an index with the given sequence number");
+      return *indices[index_seq_num];
+   }
+
+} }
+
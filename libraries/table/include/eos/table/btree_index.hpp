@@ -0,0 +1,212 @@
+#pragma once
+
+#include <eos/table/secondary_index.hpp>
+#include <eos/table/native_key.hpp>
+
+#include <iterator>
+
+namespace eos { namespace table {
+
+   // Ordered index stored as a B+tree with wide nodes.
+   // Leaves keep the first 8 bytes of the normalized key of each object inline next to the pointer to the object, so most comparisons
+   // during a search or a range scan never touch the object itself; only ties within those 8 bytes fall back to comparing the object data.
+   // Inner nodes separate their children by full normalized keys (see key_normalizer), which they own.
+   // Nodes are not merged on erase; a node is only freed once it becomes empty. Separators may therefore refer to keys no longer in the index,
+   // which is harmless since they only need to bound the keys of their children.
+   class btree_index : public secondary_index
+   {
+   public:
+
+      static constexpr index_kind kind = index_kind::btree;
+
+      static constexpr uint16_t leaf_capacity  = 64;
+      static constexpr uint16_t inner_capacity = 64; // Maximum number of children of an inner node
+
+   private:
+
+      struct node
+      {
+         bool     leaf;
+         uint16_t count = 0; // Number of entries in a leaf, or number of children of an inner node
+
+         node(bool leaf) : leaf(leaf) {}
+      };
+
+      struct leaf_node : public node
+      {
+         uint64_t              prefixes[leaf_capacity];     // Values and lengths of the key_prefix of each object, kept apart for density
+         const dynamic_object* objects[leaf_capacity];
+         uint8_t               prefix_lengths[leaf_capacity];
+         leaf_node*            prev = nullptr;
+         leaf_node*            next = nullptr;
+
+         leaf_node() : node(true) {}
+      };
+
+      struct inner_node : public node
+      {
+         normalized_key separators[inner_capacity - 1]; // separators[i] bounds the keys of children[i+1] from below
+         node*          children[inner_capacity];
+
+         inner_node() : node(false) {}
+      };
+
+      struct probe
+      {
+         const normalized_key& key;
+         key_prefix            prefix;
+         const dynamic_object* obj;                                              // Set when looking for an object,
+         int8_t                (*compare_key)(const void*, const dynamic_object&); // otherwise compares an object with the key looked up,
+         const void*           lookup;                                           // which is described by this.
+      };
+
+      // Key looked up with a comparator of objects with keys, for probe::compare_key.
+      template<typename Compare, typename Key>
+      struct key_lookup
+      {
+         const Compare& comp;
+         const Key&     key;
+
+         static int8_t compare(const void* l, const dynamic_object& o)
+         {
+            auto self = static_cast<const key_lookup*>(l);
+            return self->comp.compare(o, self->key);
+         }
+      };
+
+      using path_type = std::vector<std::pair<inner_node*, uint16_t>>;
+
+   public:
+
+      class const_iterator : public std::iterator<std::bidirectional_iterator_tag, const dynamic_object>
+      {
+      public:
+
+         const_iterator() = default;
+
+         inline const dynamic_object& operator*()const  { return *leaf->objects[pos]; }
+         inline const dynamic_object* operator->()const { return leaf->objects[pos]; }
+
+         const_iterator& operator++();
+         const_iterator& operator--();
+
+         inline const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         inline const_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+         inline bool operator==(const const_iterator& other)const { return leaf == other.leaf && pos == other.pos; }
+         inline bool operator!=(const const_iterator& other)const { return !(*this == other); }
+
+      private:
+         friend class btree_index;
+
+         const_iterator(const btree_index* tree, const leaf_node* leaf, uint16_t pos)
+            : tree(tree), leaf(leaf), pos(pos)
+         {}
+
+         const btree_index* tree = nullptr;
+         const leaf_node*   leaf = nullptr; // nullptr for end()
+         uint16_t           pos  = 0;
+      };
+
+      btree_index(const types_manager::table_index& ti);
+      ~btree_index();
+
+      btree_index(const btree_index&) = delete;
+      btree_index& operator=(const btree_index&) = delete;
+
+      virtual index_kind            get_kind()const override { return kind; }
+      virtual const dynamic_object* insert(const dynamic_object& o) override;
+      virtual void                  erase(const dynamic_object& o) override;
+      virtual void                  clear() override;
+      virtual size_t                size()const override { return num_objects; }
+      virtual void                  bulk_load(sorted_run& run) override;
+      virtual index_memory_usage    get_memory_usage()const override;
+
+      inline const_iterator begin()const { return normalize_position(first_leaf, 0); }
+      inline const_iterator end()const   { return const_iterator(this, nullptr, 0); }
+
+      const_iterator iterator_to(const dynamic_object& o)const;
+
+      // Prepares k for repeated lookups in this index (see bound_key). Throws std::invalid_argument if the data of k is malformed.
+      bound_key      bind(const dynamic_key& k)const;
+
+      const_iterator lower_bound(const bound_key& k)const;
+      const_iterator upper_bound(const bound_key& k)const;
+      const_iterator find(const bound_key& k)const;
+
+      inline std::pair<const_iterator, const_iterator> equal_range(const bound_key& k)const { return {lower_bound(k), upper_bound(k)}; }
+
+      inline const_iterator lower_bound(const dynamic_key& k)const { return lower_bound(bind(k)); }
+      inline const_iterator upper_bound(const dynamic_key& k)const { return upper_bound(bind(k)); }
+      inline const_iterator find(const dynamic_key& k)const        { return find(bind(k)); }
+
+      inline std::pair<const_iterator, const_iterator> equal_range(const dynamic_key& k)const { return equal_range(bind(k)); }
+
+      // Lookups of a native C++ key (see native_key_compare), which only encode its normalized form rather than serializing it.
+      template<typename Key>
+      const_iterator lower_bound(const Key& k, const native_key_compare<Key>& comp)const
+      {
+         auto nk = comp.normalize(k);
+         key_lookup<native_key_compare<Key>, Key> l{comp, k};
+         return lower_bound(make_probe(nk, nullptr, &l.compare, &l));
+      }
+
+      template<typename Key>
+      const_iterator upper_bound(const Key& k, const native_key_compare<Key>& comp)const
+      {
+         auto nk = comp.normalize(k);
+         key_lookup<native_key_compare<Key>, Key> l{comp, k};
+         return upper_bound(make_probe(nk, nullptr, &l.compare, &l));
+      }
+
+      template<typename Key>
+      const_iterator find(const Key& k, const native_key_compare<Key>& comp)const
+      {
+         auto itr = lower_bound(k, comp);
+         if( itr == end() || comp.compare(*itr, k) != 0 )
+            return end();
+         return itr;
+      }
+
+      template<typename Key>
+      std::pair<const_iterator, const_iterator> equal_range(const Key& k, const native_key_compare<Key>& comp)const
+      {
+         auto nk = comp.normalize(k);
+         key_lookup<native_key_compare<Key>, Key> l{comp, k};
+         auto p = make_probe(nk, nullptr, &l.compare, &l);
+         return {lower_bound(p), upper_bound(p)};
+      }
+
+   private:
+
+      compare_program            program;
+      key_normalizer             normalizer;
+      bound_key_compare          key_compare;
+      compare_stats_ref          stats;
+
+      node*      root;
+      leaf_node* first_leaf;
+      leaf_node* last_leaf;
+      size_t     num_objects = 0;
+
+      static probe   make_probe(const normalized_key& nk, const dynamic_object* obj,
+                                int8_t (*compare_key)(const void*, const dynamic_object&) = nullptr, const void* lookup = nullptr);
+      int8_t         compare_entry(const leaf_node& leaf, uint16_t pos, const probe& p)const;
+      const_iterator normalize_position(const leaf_node* leaf, uint16_t pos)const;
+
+      // Descends to the leaf that may hold p. Within each inner node, the child taken is the last one whose separator is less than p
+      // (or equal to it if past_equal_separators is set). Returns that leaf and the first position in it whose entry is greater than p
+      // (or equal to it if stop_at_equal_entries is set). If path is given, it receives the inner nodes visited and the child taken in each.
+      std::pair<leaf_node*, uint16_t> descend(const probe& p, bool past_equal_separators, bool stop_at_equal_entries, path_type* path)const;
+
+      const_iterator lower_bound(const probe& p)const;
+      const_iterator upper_bound(const probe& p)const;
+
+      void insert_into_parent(path_type& path, normalized_key separator, node* right);
+      void remove_leaf(path_type& path, leaf_node* leaf);
+      void destroy(node* n);
+      void add_memory_usage(const node* n, index_memory_usage& u)const;
+   };
+
+} }
+
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace eos { namespace table {
+
+   // Allocator that keeps a count of the bytes it currently has allocated, for the memory accounting of node-based containers.
+   // Copies (including those rebound to other types, e.g. to the nodes of a container) share the counter, which must outlive all of them.
+   // The counter is not synchronized, so a container using it must not be changed by several threads at once.
+   template<typename T>
+   class counting_allocator
+   {
+   public:
+
+      using value_type = T;
+
+      explicit counting_allocator(uint64_t* counter)
+         : counter(counter)
+      {}
+
+      template<typename U>
+      counting_allocator(const counting_allocator<U>& other)
+         : counter(other.counter)
+      {}
+
+      T* allocate(size_t n)
+      {
+         auto p = std::allocator<T>().allocate(n);
+         *counter += n * sizeof(T);
+         return p;
+      }
+
+      void deallocate(T* p, size_t n)
+      {
+         *counter -= n * sizeof(T);
+         std::allocator<T>().deallocate(p, n);
+      }
+
+      template<typename U>
+      inline bool operator==(const counting_allocator<U>& other)const { return counter == other.counter; }
+
+      template<typename U>
+      inline bool operator!=(const counting_allocator<U>& other)const { return counter != other.counter; }
+
+   private:
+      template<typename U>
+      friend class counting_allocator;
+
+      uint64_t* counter;
+   };
+
+} }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <eos/eoslib/raw_region.hpp>
+#include <eos/eoslib/compare_program.hpp>
 #include <eos/types/types_manager.hpp>
 
+#include <algorithm>
+
 namespace eos { namespace table {
 
    using namespace eos::types;
@@ -17,20 +20,27 @@ namespace eos { namespace table {
    {
    public:
 
-      dynamic_object_compare(const types_manager::table_index& ti)
-         : ti(ti)
+      // If trusted is set, the data of all compared objects must have passed compare_program::validate for the index, and is read without bounds checks.
+      dynamic_object_compare(const types_manager::table_index& ti, bool trusted = false)
+         : program(ti), trusted(trusted), stats(ti)
       {}
 
       bool operator()(const dynamic_object& lhs, const dynamic_object& rhs)const;
 
    private:
-      types_manager::table_index ti;
+      compare_program   program; // Compiled once from the table_index when the table is built.
+      bool              trusted;
+      compare_stats_ref stats;
    };
 
+   // Key of an index. If num_members is less than the number of sorted members of the key, only that many leading members take part in
+   // comparisons, so that a lookup matches every object whose key starts with those members (e.g. all (a, *) of a composite key (a, b)).
    struct dynamic_key
    {
-      dynamic_key(const raw_region& r)
-         : data(r) 
+      static constexpr uint16_t all_members = std::numeric_limits<uint16_t>::max();
+
+      dynamic_key(const raw_region& r, uint16_t num_members = all_members)
+         : data(r), num_members(num_members)
       {}
 
       dynamic_key(const dynamic_object& o)
@@ -38,6 +48,7 @@ namespace eos { namespace table {
       {}
 
       const raw_region& data;
+      uint16_t          num_members = all_members;
    };
 
    class dynamic_key_compare
@@ -45,7 +56,7 @@ namespace eos { namespace table {
    public:
 
       dynamic_key_compare(const types_manager::table_index& ti)
-         : ti(ti)
+         : ti(ti), stats(ti)
       {}
 
       bool operator()(const dynamic_object& lhs, const dynamic_key& rhs)const;
@@ -53,6 +64,162 @@ namespace eos { namespace table {
 
    private:
       types_manager::table_index ti;
+      compare_stats_ref          stats;
+   };
+
+   // Byte string whose memcmp order matches the order of an index (see compare_program::normalize).
+   // Normalized keys of objects in non-unique indices end with the big-endian id, so that they are unique as well.
+   struct normalized_key
+   {
+      vector<byte> data;
+   };
+
+   // Lookup key prepared for an index by bound_key_compare::bind (and by the bind of the ordered indices of dynamic_table): its data has been
+   // checked against the layout of the key once, so that comparing it with objects does nothing but compare data. It can be reused for any
+   // number of lookups in indices of the same table_index, but refers to the data of the dynamic_key it was bound from, which must outlive it.
+   class bound_key
+   {
+   public:
+
+      inline const raw_region& get_data()const        { return data; }
+      inline uint16_t          get_num_members()const { return num_members; }
+
+      normalized_key normalized; // Normalized form of the key, if the index it was bound for compares normalized keys
+
+   private:
+      friend class bound_key_compare;
+
+      bound_key(const dynamic_key& k, uint32_t end)
+         : data(k.data), num_members(k.num_members), end(end)
+      {}
+
+      const raw_region& data;
+      uint16_t          num_members;
+      uint32_t          end; // End of the steps of the compared members (see compare_program::get_members_end)
+   };
+
+   // Comparison of objects with bound keys. The layouts of the key and of the view into the object are checked against each other once,
+   // when it is constructed, rather than on every comparison like dynamic_key_compare.
+   class bound_key_compare
+   {
+   public:
+
+      // See dynamic_object_compare for trusted.
+      bound_key_compare(const types_manager::table_index& ti, bool trusted = false);
+
+      // Throws std::invalid_argument if the data of k is malformed for the (compared members of the) key of the index.
+      bound_key bind(const dynamic_key& k)const;
+
+      int8_t compare(const dynamic_object& o, const bound_key& k)const;
+
+      inline bool operator()(const dynamic_object& lhs, const bound_key& rhs)const { return compare(lhs, rhs) < 0; }
+      inline bool operator()(const bound_key& lhs,    const dynamic_object& rhs)const { return compare(rhs, lhs) > 0; }
+
+   private:
+      compare_program   object_program;
+      compare_program   key_program;
+      vector<uint32_t>  key_bases;
+      bool              trusted;
+      compare_stats_ref stats;
+   };
+
+   // Plain memcmp order, except that a key which is a prefix of another compares equal to it.
+   // Normalized keys of the objects in an index are never prefixes of one another, so this is still a strict weak ordering over them,
+   // but it also lets a lookup key (which lacks the id suffix) match every object with that key in a non-unique index.
+   class normalized_key_compare
+   {
+   public:
+
+      static int compare(const normalized_key& lhs, const normalized_key& rhs);
+
+      inline bool operator()(const normalized_key& lhs, const normalized_key& rhs)const { return compare(lhs, rhs) < 0; }
+   };
+
+   // First 8 bytes of a normalized key packed into an integer, big-endian and zero-padded ("abbreviated key"). Comparing the prefixes of two
+   // normalized keys decides the order of the keys whenever the prefixes differ within the shorter of their lengths; otherwise the keys must
+   // be compared in full.
+   struct key_prefix
+   {
+      uint64_t value  = 0;
+      uint8_t  length = 0;
+
+      key_prefix() = default;
+      explicit key_prefix(const normalized_key& k);
+
+      // Returns 0 if the prefixes do not decide the order of their keys.
+      static inline int8_t compare(uint64_t lhs, uint8_t lhs_length, uint64_t rhs, uint8_t rhs_length)
+      {
+         auto n = std::min(lhs_length, rhs_length);
+         if( n == 0 )
+            return 0;
+         uint64_t mask = (n == sizeof(uint64_t)) ? ~uint64_t(0) : ~(~uint64_t(0) >> (8 * n));
+         lhs &= mask;
+         rhs &= mask;
+         if( lhs == rhs )
+            return 0;
+         return (lhs < rhs) ? -1 : 1;
+      }
+
+      static inline int8_t compare(const key_prefix& lhs, const key_prefix& rhs) { return compare(lhs.value, lhs.length, rhs.value, rhs.length); }
+   };
+
+   class key_normalizer
+   {
+   public:
+
+      key_normalizer(const types_manager::table_index& ti)
+         : object_program(ti), key_program(ti, compare_program::key_view)
+      {}
+
+      normalized_key operator()(const dynamic_object& o)const;
+      normalized_key operator()(const dynamic_key& k)const;
+
+      // Number of sorted members of the key of the index.
+      inline uint16_t get_num_key_members()const { return key_program.get_num_members(); }
+
+      // Size of every normalized key of an object, or 0 if it depends on the object.
+      uint32_t       get_object_key_size()const;
+
+   private:
+      compare_program object_program;
+      compare_program key_program;
+   };
+
+   // Hash and equality for hashed indices. Equal keys have equal normalized keys, so hashing the normalized key is consistent with equality,
+   // except for keys containing rationals: 0/0 compares equal to every value but is encoded as 0. Hashed indices therefore reject such keys
+   // (see hashed_index).
+   class dynamic_object_hash
+   {
+   public:
+
+      dynamic_object_hash(const types_manager::table_index& ti)
+         : normalizer(ti)
+      {}
+
+      size_t operator()(const dynamic_object& o)const;
+      size_t operator()(const dynamic_key& k)const;
+
+   private:
+      key_normalizer normalizer;
+   };
+
+   class dynamic_object_equal
+   {
+   public:
+
+      // See dynamic_object_compare for trusted.
+      dynamic_object_equal(const types_manager::table_index& ti, bool trusted = false)
+         : ti(ti), program(ti), trusted(trusted), stats(ti)
+      {}
+
+      bool operator()(const dynamic_object& lhs, const dynamic_object& rhs)const;
+      bool operator()(const dynamic_key& lhs,    const dynamic_object& rhs)const;
+
+   private:
+      types_manager::table_index ti;
+      compare_program            program;
+      bool                       trusted;
+      compare_stats_ref          stats;
    };
 
 } }
@@ -1,16 +1,31 @@
 #pragma once
 
 #include <eos/table/dynamic_object.hpp>
+#include <eos/table/secondary_index.hpp>
+#include <eos/table/btree_index.hpp>
+#include <eos/table/native_key.hpp>
+#include <eos/table/slab_allocator.hpp>
+#include <eos/table/table_image.hpp>
+#include <eos/table/counting_allocator.hpp>
+#include <eos/eoslib/memory_usage.hpp>
 #include <eos/eoslib/type_id.hpp>
 #include <eos/types/types_manager.hpp>
 
+#include <chrono>
+#include <iosfwd>
 #include <type_traits>
 #include <stdexcept>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/preprocessor/repetition/repeat.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/mpl/size.hpp>
 
 namespace bmi = boost::multi_index;
 
@@ -51,8 +66,258 @@ namespace eos { namespace table {
 
    BOOST_PP_REPEAT(10, EOS_TABLE_MAKE_ALIAS, _) // Limited to 9 user-specified indices (or 10 indices total for Boost.MultiIndex when counting the id index)
                                                 // because boost::make_tuple only supports tuples up to a maximum size of 10.
+                                                // Use dynamic_table below for tables with more indices.
 
    BOOST_PP_REPEAT(10, EOS_TABLE_CTOR_ARGS_LIST_MAKER, _)
 
+   // Memory held by a table (see dynamic_table::get_memory_usage), in bytes requested from the allocators.
+   struct table_memory_usage
+   {
+      uint64_t                        num_objects          = 0;
+      memory_usage                    payloads;                 // Data of the objects neither inline nor shared: used is its size, reserved its capacity
+      uint64_t                        inline_payload_bytes = 0; // Size of the data stored inline, which lies within the objects (see raw_region)
+      memory_usage                    shared_payloads;          // Data of the objects shared with other regions (counted in full even so)
+      memory_usage                    undo_payloads;            // Data kept to undo the changes of the active sessions, counted like payloads
+      memory_usage                    payload_blocks;           // Allocations holding payloads and undo_payloads: for a dynamic_table, the blocks
+                                                                // in use and the slabs reserved by its slab_allocator
+      uint64_t                        object_bytes         = 0; // Nodes holding the objects, i.e. those of the id index of a dynamic_table
+      std::vector<index_memory_usage> indices;                  // Secondary indices of a dynamic_table
+
+      void     count_object(const raw_region& data);
+      void     count_undo_data(const raw_region& data);
+
+      uint64_t get_total()const;
+      void     print(std::ostream& os)const;
+   };
+
+   // Memory held by a dynamic_table_N. Unlike for dynamic_table, the nodes of Boost.MultiIndex are not counted as they are allocated but
+   // derived from their layout: each holds an object and, per index, three pointers (the parent, whose low bit holds the color of the node,
+   // and the two children), and one more node is the header of the trees. The indices share the nodes, so object_bytes covers them all.
+   template<typename Indices>
+   table_memory_usage get_memory_usage(const bmi::multi_index_container<dynamic_object, Indices>& table)
+   {
+      table_memory_usage u;
+      for( const auto& o : table )
+         u.count_object(o.data);
+      u.payload_blocks.used     = u.payloads.reserved;
+      u.payload_blocks.reserved = u.payloads.reserved;
+      u.object_bytes = (table.size() + 1) * (sizeof(dynamic_object) + boost::mpl::size<Indices>::value * 3 * sizeof(void*));
+      return u;
+   }
+
+   // Table whose indices are set up at run-time from the types_manager, so there is no limit on their number.
+   // Objects are stored in id order; each secondary index refers to the stored objects rather than holding copies of them.
+   // The data of stored objects is copied into memory owned by the table (see slab_allocator) as they enter it, unless it is small enough to be
+   // stored inline or is shared (see raw_region::share), in which case the table shares it with the other copies of the object rather than
+   // copying it. Copies of stored objects (or of their data) are independent of the table, but data moved out of it (e.g. by swapping) must
+   // not outlive the table, unless it is shared.
+   class dynamic_table
+   {
+   public:
+
+      using object_container = bmi::multi_index_container<
+                                  dynamic_object,
+                                  bmi::indexed_by<bmi::ordered_unique<bmi::member<dynamic_object, uint64_t, &dynamic_object::id>>>,
+                                  counting_allocator<dynamic_object>
+                               >;
+      using const_iterator   = object_container::const_iterator;
+
+      struct bulk_load_rejection
+      {
+         size_t  position;      // Position of the rejected object within the batch
+         int16_t index_seq_num; // Index in which its key equals that of an earlier object of the batch, or -1 if it is its id that does
+      };
+
+      // Changes made while a session is active can be undone as a whole. Sessions nest: starting a session while another one is active creates
+      // a savepoint within it. Each session only records the first change to any object (its original data), so undoing costs O(changes).
+      class session
+      {
+      public:
+
+         session(session&& other);
+         session& operator=(session&& other);
+         ~session(); // Undoes the changes unless push, squash or undo has been called.
+
+         session(const session&) = delete;
+         session& operator=(const session&) = delete;
+
+         void push();   // Keeps the changes, which remain undoable through dynamic_table::undo until committed.
+         void squash(); // Merges the changes into those of the enclosing session (or commits them if there is none).
+         void undo();
+
+      private:
+         friend class dynamic_table;
+
+         session(dynamic_table& table, bool apply)
+            : table(&table), apply(apply)
+         {}
+
+         dynamic_table* table;
+         bool           apply;
+      };
+
+      // ordered_index_kind selects the engine (index_kind::ordered or index_kind::btree) used for the ordered indices of the table.
+      // Throws std::invalid_argument if a hashed index has a key that cannot be hashed (see hashed_index).
+      dynamic_table(const types_manager& tm, type_id::index_t tbl_indx, index_kind ordered_index_kind = index_kind::ordered);
+
+      dynamic_table(const dynamic_table&) = delete;
+      dynamic_table& operator=(const dynamic_table&) = delete;
+
+      // If the id or the key of any unique index is already taken, the table is left unchanged and the returned iterator points to the conflicting object.
+      // Throws std::invalid_argument (leaving the table unchanged) if the data of o is malformed, which is also the case for modify and bulk_load.
+      std::pair<const_iterator, bool> insert(dynamic_object o);
+
+      // Replaces the data of the object at itr. Returns false (and leaves the table unchanged) if the new data would violate a unique index.
+      bool           modify(const_iterator itr, raw_region new_data);
+
+      // Fills an empty table with a batch of objects. Rather than inserting them one by one, each index is sorted once (the indices in parallel)
+      // and then built from its sorted run in linear time. An object is rejected if its id, or its key in a unique index, equals that of an object
+      // earlier in the batch (whether or not that object is accepted itself). Accepted objects are moved out of batch, while rejected ones are
+      // left in place and reported in batch order (each under the first index in which it collides).
+      std::vector<bulk_load_rejection> bulk_load(std::vector<dynamic_object>& batch);
+
+      // Writes the objects of the table to a table_image at path, along with the order of each of its ordered indices unless keep_orders is false
+      // (which makes the image smaller and faster to write, but slower to load).
+      void           save(const std::string& path, bool keep_orders = true)const;
+
+      // Fills an empty table from the table_image at path, which must have been saved from a table of the same definition (as checked through
+      // the fingerprint of the types_manager and the description of each index). The indices are rebuilt in parallel. An ordered index whose
+      // order was saved is built from it in linear time, after checking that it agrees with the keys; otherwise its keys are sorted first, as in
+      // bulk_load. Throws std::runtime_error (leaving the table empty) if the image is malformed or was saved for another definition, and
+      // std::invalid_argument if the data of an object is malformed.
+      void           load(const std::string& path);
+
+      const_iterator erase(const_iterator itr);
+      size_t         erase(uint64_t id);
+      void           clear();
+
+      inline const_iterator find(uint64_t id)const { return objects.find(id); }
+      inline const_iterator begin()const           { return objects.begin(); }
+      inline const_iterator end()const             { return objects.end(); }
+      inline size_t         size()const            { return objects.size(); }
+      inline bool           empty()const           { return objects.empty(); }
+
+      // If enabled is false, the returned session does nothing and changes made during it are not recorded (unless an enclosing session is active).
+      session start_undo_session(bool enabled = true);
+
+      void   undo();   // Undoes the changes of the innermost session
+      void   squash(); // Merges the changes of the innermost session into the enclosing one
+      void   commit(); // Forgets all recorded changes, so they can no longer be undone
+
+      inline size_t get_undo_depth()const { return undo_stack.size(); }
+
+      inline const types_manager& get_types_manager()const   { return tm; }
+      inline type_id::index_t     get_table_index()const     { return tbl_indx; }
+      inline uint8_t              get_num_indices()const     { return static_cast<uint8_t>(indices.size()); }
+
+      inline const slab_allocator& get_payload_allocator()const { return payloads; }
+
+      // Walks the objects and the indices, so it takes time linear in the size of the table.
+      table_memory_usage           get_memory_usage()const;
+
+      // index_seq_num is the same as in types_manager::get_table_index (i.e. the id index is not counted).
+      const secondary_index& get_index(uint8_t index_seq_num)const;
+
+      template<class Index>
+      const Index& get_index(uint8_t index_seq_num)const
+      {
+         const auto& index = get_index(index_seq_num);
+         if( index.get_kind() != Index::kind )
+            throw std::invalid_argument("Index is not of the requested kind");
+         return static_cast<const Index&>(index);
+      }
+
+      // Lookups of a native C++ key (see native_key_compare) in the ordered index index_seq_num, whose engine is Index (ordered_index or
+      // btree_index). Throws std::invalid_argument if Key does not match the key of the index, or if the index is of another kind.
+      // To look up many keys, construct a native_key_compare once and use the lookups of the index itself.
+      template<class Index, typename Key>
+      typename Index::const_iterator lower_bound(uint8_t index_seq_num, const Key& k)const
+      {
+         return get_index<Index>(index_seq_num).lower_bound(k, native_key_compare<Key>(tm.get_table_index(tbl_indx, index_seq_num)));
+      }
+
+      template<class Index, typename Key>
+      typename Index::const_iterator upper_bound(uint8_t index_seq_num, const Key& k)const
+      {
+         return get_index<Index>(index_seq_num).upper_bound(k, native_key_compare<Key>(tm.get_table_index(tbl_indx, index_seq_num)));
+      }
+
+      template<class Index, typename Key>
+      typename Index::const_iterator find(uint8_t index_seq_num, const Key& k)const
+      {
+         return get_index<Index>(index_seq_num).find(k, native_key_compare<Key>(tm.get_table_index(tbl_indx, index_seq_num)));
+      }
+
+      template<class Index, typename Key>
+      std::pair<typename Index::const_iterator, typename Index::const_iterator> equal_range(uint8_t index_seq_num, const Key& k)const
+      {
+         return get_index<Index>(index_seq_num).equal_range(k, native_key_compare<Key>(tm.get_table_index(tbl_indx, index_seq_num)));
+      }
+
+   private:
+
+      struct undo_state
+      {
+         std::unordered_map<uint64_t, raw_region> old_values;     // Data of objects modified during the session, as it was before
+         std::unordered_map<uint64_t, raw_region> removed_values; // Data of objects removed during the session
+         std::unordered_set<uint64_t>             new_ids;        // Objects inserted during the session
+      };
+
+      const types_manager&                          tm;
+      type_id::index_t                              tbl_indx;
+      slab_allocator                                payloads; // Holds the data of objects, so it must outlive every member below
+      uint64_t                                      object_bytes = 0; // Allocated by objects (see counting_allocator)
+      object_container                              objects;
+      std::vector<std::unique_ptr<secondary_index>> indices;
+      std::vector<compare_program>                  key_layouts; // One per index, to validate the data of objects once before they enter the indices
+      std::deque<undo_state>                        undo_stack;
+
+      void validate(const raw_region& data)const;
+      void adopt(raw_region& data); // Moves data into payloads, unless it is inline, shared or already there
+
+      // Adds o to all secondary indices. On failure o is removed from the ones it was already added to and the conflicting object is returned.
+      const dynamic_object* add_to_indices(const dynamic_object& o);
+      void                  remove_from_indices(const dynamic_object& o);
+
+      void on_insert(uint64_t id);
+      void on_modify(uint64_t id, raw_region& old_data); // May move from old_data
+      void on_remove(const_iterator itr);                // May move from the data of the object (which must already be out of the indices)
+   };
+
+   inline table_memory_usage get_memory_usage(const dynamic_table& table)
+   {
+      return table.get_memory_usage();
+   }
+
+   // Prints the memory usage of a table (see table_memory_usage::print) at most once per period, starting with the first poll.
+   // Tables are not thread-safe, so rather than running on a timer of its own, it is polled by the thread that changes the table
+   // (e.g. after each batch of changes).
+   class memory_usage_dump
+   {
+   public:
+
+      memory_usage_dump(std::ostream& os, std::chrono::steady_clock::duration period)
+         : os(os), period(period)
+      {}
+
+      // Returns whether the usage of table was printed. Table is a dynamic_table or a dynamic_table_N.
+      template<class Table>
+      bool poll(const Table& table)
+      {
+         auto now = std::chrono::steady_clock::now();
+         if( now < next )
+            return false;
+
+         next = now + period;
+         get_memory_usage(table).print(os);
+         return true;
+      }
+
+   private:
+      std::ostream&                         os;
+      std::chrono::steady_clock::duration   period;
+      std::chrono::steady_clock::time_point next;
+   };
+
 } }
 
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <eos/table/dynamic_object.hpp>
+#include <eos/types/reflect.hpp>
+#include <eos/eoslib/compare_kernels.hpp>
+#include <eos/eoslib/key_encoding.hpp>
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace eos { namespace table {
+
+   // Comparison of a native C++ value with the field of builtin type B at an offset within the data of an object, and encoding of the value
+   // into a normalized key (see compare_program::normalize).
+   template<type_id::builtin B>
+   struct native_builtin
+   {
+      using is_supported = std::false_type;
+   };
+
+   template<typename I>
+   struct native_integer
+   {
+      using is_supported = std::true_type;
+
+      template<typename T>
+      static inline int8_t compare(const trusted_region& object, uint32_t offset, const T& v)
+      {
+         static_assert( std::is_integral<T>::value, "Native key member for an integer field must be of an integral type" );
+         return compare_primitives(object.get<I>(offset), static_cast<I>(v));
+      }
+
+      template<typename T>
+      static inline void encode(const T& v, vector<byte>& out)
+      {
+         encode_integer(static_cast<I>(v), out);
+      }
+   };
+
+   template<> struct native_builtin<type_id::builtin_int8>   : native_integer<int8_t>   {};
+   template<> struct native_builtin<type_id::builtin_uint8>  : native_integer<uint8_t>  {};
+   template<> struct native_builtin<type_id::builtin_int16>  : native_integer<int16_t>  {};
+   template<> struct native_builtin<type_id::builtin_uint16> : native_integer<uint16_t> {};
+   template<> struct native_builtin<type_id::builtin_int32>  : native_integer<int32_t>  {};
+   template<> struct native_builtin<type_id::builtin_uint32> : native_integer<uint32_t> {};
+   template<> struct native_builtin<type_id::builtin_int64>  : native_integer<int64_t>  {};
+   template<> struct native_builtin<type_id::builtin_uint64> : native_integer<uint64_t> {};
+
+   template<>
+   struct native_builtin<type_id::builtin_bool>
+   {
+      using is_supported = std::true_type;
+
+      static inline int8_t compare(const trusted_region& object, uint32_t offset, bool v)
+      {
+         return compare_primitives(object.get<bool>(offset << 3), v);
+      }
+
+      static inline void encode(bool v, vector<byte>& out)
+      {
+         out.push_back( v ? 1 : 0 );
+      }
+   };
+
+   template<>
+   struct native_builtin<type_id::builtin_rational>
+   {
+      using is_supported = std::true_type;
+
+      static inline int8_t compare(const trusted_region& object, uint32_t offset, const rational& v)
+      {
+         return compare_rationals(object.get<int64_t>(offset), object.get<uint64_t>(offset+8), v.numerator, v.denominator);
+      }
+
+      static inline void encode(const rational& v, vector<byte>& out)
+      {
+         encode_rational(v.numerator, v.denominator, out);
+      }
+   };
+
+   // Bytes, given as any contiguous container of bytes (e.g. std::vector<uint8_t>).
+   struct native_byte_range
+   {
+      using is_supported = std::true_type;
+
+      template<typename T>
+      static inline int8_t compare(const trusted_region& object, uint32_t offset, const T& v)
+      {
+         auto num_elements = object.get<uint32_t>(offset);
+         auto data_offset  = object.get<uint32_t>(offset+4);
+         return compare_integer_runs<uint8_t>(object.get_data() + data_offset, num_elements,
+                                              reinterpret_cast<const byte*>(v.data()), static_cast<uint32_t>(v.size()));
+      }
+
+      template<typename T>
+      static inline void encode(const T& v, vector<byte>& out)
+      {
+         encode_bytes(reinterpret_cast<const byte*>(v.data()), static_cast<uint32_t>(v.size()), out);
+      }
+   };
+
+   template<> struct native_builtin<type_id::builtin_bytes> : native_byte_range {};
+
+   // Serialized strings count a terminating zero, except when empty (see write_visitor::write_vector).
+   template<>
+   struct native_builtin<type_id::builtin_string>
+   {
+      using is_supported = std::true_type;
+
+      template<typename T>
+      static inline int8_t compare(const trusted_region& object, uint32_t offset, const T& v)
+      {
+         auto num_elements = object.get<uint32_t>(offset);
+         auto data_offset  = object.get<uint32_t>(offset+4);
+         return compare_integer_runs<uint8_t>(object.get_data() + data_offset, num_elements,
+                                              reinterpret_cast<const byte*>(v.c_str()), serialized_size(v));
+      }
+
+      template<typename T>
+      static inline void encode(const T& v, vector<byte>& out)
+      {
+         encode_bytes(reinterpret_cast<const byte*>(v.c_str()), serialized_size(v), out);
+      }
+
+      template<typename T>
+      static inline uint32_t serialized_size(const T& v)
+      {
+         return (v.size() == 0 ? 0 : static_cast<uint32_t>(v.size()) + 1);
+      }
+   };
+
+   // References to the members of a native key Key, in the order of the sorted members of the key of an index:
+   // a value of a builtin type is the single member, a struct reflected with sorted members has those, and a std::tuple has its elements.
+   template<typename Key, typename Enable = void>
+   struct native_key_members;
+
+   template<typename Key>
+   struct native_key_members<Key, typename std::enable_if<reflector<Key>::is_builtin::value>::type>
+   {
+      static inline auto tie(const Key& k) { return std::tie(k); }
+   };
+
+   template<typename Key>
+   struct native_key_members<Key, typename std::enable_if<(std::tuple_size<typename reflector<Key>::sorted_members>::value > 0)>::type>
+   {
+      static inline auto tie(const Key& k) { return reflector<Key>::tie_sorted_members(k); }
+   };
+
+   template<typename... Ts>
+   struct native_key_members<std::tuple<Ts...>>
+   {
+      static inline auto tie(const std::tuple<Ts...>& k) { return tie(k, std::index_sequence_for<Ts...>()); }
+
+      template<size_t... I>
+      static inline auto tie(const std::tuple<Ts...>& k, std::index_sequence<I...>) { return std::tie(std::get<I>(k)...); }
+   };
+
+   // Comparison of objects with a native C++ key Key (see native_key_members), which avoids serializing the key into a raw_region.
+   // The members of the key must all be of builtin types. A key with fewer members than the key of the index (e.g. a std::tuple of its first
+   // members) is compared with the leading sorted members only, like a dynamic_key restricted to some of its members.
+   // The data of the compared objects must have passed compare_program::validate for the index, and is read without bounds checks.
+   template<typename Key>
+   class native_key_compare
+   {
+      using tied_type = decltype(native_key_members<Key>::tie(std::declval<const Key&>()));
+
+      static constexpr size_t num_members = std::tuple_size<tied_type>::value;
+
+      template<size_t I>
+      using member_type = typename std::decay<typename std::tuple_element<I, tied_type>::type>::type;
+
+      template<size_t I>
+      using builtin_at  = native_builtin<reflector<member_type<I>>::builtin_type>;
+
+   public:
+
+      // Throws std::invalid_argument if the members of Key do not match the (leading) sorted members of the key of the index.
+      native_key_compare(const types_manager::table_index& ti)
+         : stats(ti)
+      {
+         auto sorted_members = ti.get_sorted_members();
+         if( static_cast<size_t>(sorted_members.end() - sorted_members.begin()) < num_members )
+            throw std::invalid_argument("Native key has more members than the key of the index");
+
+         init(sorted_members.begin(), ti.is_ascending(), std::make_index_sequence<num_members>());
+      }
+
+      int8_t compare(const dynamic_object& o, const Key& k)const
+      {
+         EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), true);
+         return compare_members(trusted_region(o.data), native_key_members<Key>::tie(k), std::make_index_sequence<num_members>());
+      }
+
+      inline bool operator()(const dynamic_object& lhs, const Key& rhs)const { return compare(lhs, rhs) < 0; }
+      inline bool operator()(const Key& lhs, const dynamic_object& rhs)const { return compare(rhs, lhs) > 0; }
+
+      // Normalized form of k, which is a prefix of the normalized keys (see key_normalizer) of the objects that compare equal to k.
+      normalized_key normalize(const Key& k)const
+      {
+         normalized_key nk;
+         encode_members(native_key_members<Key>::tie(k), nk.data, std::make_index_sequence<num_members>());
+         return nk;
+      }
+
+      inline uint16_t get_num_members()const { return static_cast<uint16_t>(num_members); }
+
+   private:
+
+      template<typename Iterator, size_t... I>
+      void init(Iterator itr, bool index_ascending, std::index_sequence<I...>)
+      {
+         bool ok[] = { true, init_member<I>(*(itr + I), index_ascending)... };
+         (void)ok;
+      }
+
+      template<size_t I>
+      bool init_member(const field_metadata& f, bool index_ascending)
+      {
+         static_assert( reflector<member_type<I>>::is_builtin::value, "Members of a native key must be of builtin types" );
+         static_assert( builtin_at<I>::is_supported::value, "Members of a native key cannot be of the Any type" );
+
+         if( !(f.get_type_id() == type_id(reflector<member_type<I>>::builtin_type)) )
+            throw std::invalid_argument("Native key does not match the types of the sorted members of the key of the index");
+
+         offsets[I]   = f.get_offset();
+         ascending[I] = ((f.get_sort_order() == field_metadata::ascending) == index_ascending);
+         return true;
+      }
+
+      template<size_t... I>
+      inline int8_t compare_members(const trusted_region& object, const tied_type& k, std::index_sequence<I...>)const
+      {
+         int8_t c = 0;
+         bool done[] = { false, (c == 0 && (c = compare_member<I>(object, std::get<I>(k))) != 0)... }; // Stops at the first difference
+         (void)done;
+         return c;
+      }
+
+      template<size_t I>
+      inline int8_t compare_member(const trusted_region& object, const member_type<I>& v)const
+      {
+         auto c = builtin_at<I>::compare(object, offsets[I], v);
+         return (ascending[I] ? c : -c);
+      }
+
+      template<size_t... I>
+      void encode_members(const tied_type& k, vector<byte>& out, std::index_sequence<I...>)const
+      {
+         bool ok[] = { true, encode_member<I>(std::get<I>(k), out)... };
+         (void)ok;
+      }
+
+      template<size_t I>
+      bool encode_member(const member_type<I>& v, vector<byte>& out)const
+      {
+         auto start = out.size();
+         builtin_at<I>::encode(v, out);
+         if( !ascending[I] )
+            invert_bytes(out, start);
+         return true;
+      }
+
+      std::array<uint32_t, num_members> offsets;
+      std::array<bool, num_members>     ascending;
+      compare_stats_ref                 stats;
+   };
+
+} }
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <eos/table/dynamic_object.hpp>
+#include <eos/table/counting_allocator.hpp>
+#include <eos/types/types_manager.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+
+#include <cstring>
+
+namespace eos { namespace table {
+
+   namespace bmi = boost::multi_index;
+
+   enum class index_kind : uint8_t
+   {
+      ordered = 0, // Red-black tree (Boost.MultiIndex)
+      btree,       // See btree_index
+      hashed       // Hash table (Boost.MultiIndex); used for the indices declared as hashed (e.g. u_hash) regardless of the engine of ordered indices
+   };
+
+   // Memory held by a secondary index (see secondary_index::get_memory_usage), in bytes requested from the allocator.
+   struct index_memory_usage
+   {
+      index_kind kind;
+      uint64_t   nodes      = 0; // Tree nodes, hash nodes, or leaves and inner nodes of a btree_index
+      uint64_t   node_bytes = 0; // Including the header node of a tree and the buckets of a hash table
+      uint64_t   key_bytes  = 0; // Normalized keys owned by the nodes outside of themselves, i.e. the separators of a btree_index
+
+      inline uint64_t get_total()const { return node_bytes + key_bytes; }
+   };
+
+   // Objects paired with their normalized keys (see key_normalizer), sorted in the order of an index and free of duplicates.
+   using sorted_run = std::vector<std::pair<normalized_key, const dynamic_object*>>;
+
+   // A secondary index of a dynamic_table. It only refers to the objects, which are owned (and kept at stable addresses) by the table.
+   // The data of every object added to an index must have passed compare_program::validate for it (dynamic_table checks this on insert and
+   // modify), so that comparisons between objects can skip bounds checks.
+   class secondary_index
+   {
+   public:
+
+      virtual ~secondary_index() {}
+
+      virtual index_kind get_kind()const = 0;
+
+      // Returns nullptr on success; otherwise returns the object that conflicts with o (and o is not added).
+      virtual const dynamic_object* insert(const dynamic_object& o) = 0;
+      virtual void                  erase(const dynamic_object& o) = 0;
+      virtual void                  clear() = 0;
+      virtual size_t                size()const = 0;
+
+      // Fills an empty index with the objects of run in linear time. The keys of run may be moved from.
+      virtual void                  bulk_load(sorted_run& run) = 0;
+
+      virtual index_memory_usage    get_memory_usage()const = 0;
+   };
+
+   // Red-black tree of entries referring to the objects.
+   // If the normalized keys (see key_normalizer) of the index all have the same size of at most max_cached_key_size bytes, which is the case for
+   // keys made of a few integers or bools, each entry can also carry a copy of the normalized key of its object. Comparisons within the index
+   // are then a memcmp of two entries and never touch the objects.
+   // Otherwise each entry carries the key_prefix of its object instead, and only comparisons that the prefixes leave undecided (e.g. between
+   // strings sharing their first bytes) fall back to comparing the objects.
+   class ordered_index : public secondary_index
+   {
+   public:
+
+      static constexpr index_kind kind = index_kind::ordered;
+
+      static constexpr uint32_t max_cached_key_size = 24;
+
+      struct entry
+      {
+         const dynamic_object* obj;
+         key_prefix            prefix;                   // Abbreviated normalized key of obj, if keys are abbreviated
+         byte                  key[max_cached_key_size]; // Normalized key of obj, if cached
+      };
+
+   private:
+
+      class entry_compare
+      {
+      public:
+
+         entry_compare(const types_manager::table_index& ti, uint32_t cached_key_size, bool abbreviated_keys)
+            : object_compare(ti, true), cached_key_size(cached_key_size), abbreviated_keys(abbreviated_keys)
+         {}
+
+         inline bool operator()(const entry& lhs, const entry& rhs)const
+         {
+            if( cached_key_size > 0 )
+               return (std::memcmp(lhs.key, rhs.key, cached_key_size) < 0);
+            if( abbreviated_keys )
+            {
+               auto c = key_prefix::compare(lhs.prefix, rhs.prefix);
+               if( c != 0 )
+                  return (c < 0);
+            }
+            return object_compare(*lhs.obj, *rhs.obj);
+         }
+
+      private:
+         dynamic_object_compare object_compare;
+         uint32_t               cached_key_size;
+         bool                   abbreviated_keys;
+      };
+
+      // Compares entries with keys using a comparator of dynamic_objects with keys.
+      template<typename Compare>
+      struct object_compare_adapter
+      {
+         const Compare& comp;
+
+         template<typename Key>
+         inline bool operator()(const entry& lhs, const Key& rhs)const { return comp(*lhs.obj, rhs); }
+
+         template<typename Key>
+         inline bool operator()(const Key& lhs, const entry& rhs)const { return comp(lhs, *rhs.obj); }
+      };
+
+      // Compares cached keys with the normalized key of a lookup key, which may be shorter (it lacks the id of non-unique indices).
+      struct cached_key_compare
+      {
+         inline bool operator()(const entry& lhs, const normalized_key& rhs)const
+         {
+            return (std::memcmp(lhs.key, rhs.data.data(), rhs.data.size()) < 0);
+         }
+
+         inline bool operator()(const normalized_key& lhs, const entry& rhs)const
+         {
+            return (std::memcmp(lhs.data.data(), rhs.key, lhs.data.size()) < 0);
+         }
+      };
+
+      // Compares abbreviated keys with the key_prefix of a bound lookup key, and falls back to comparing the objects with the key on ties.
+      struct abbreviated_key_compare
+      {
+         key_prefix               prefix;
+         const bound_key_compare& comp;
+
+         inline bool operator()(const entry& lhs, const bound_key& rhs)const
+         {
+            auto c = key_prefix::compare(lhs.prefix, prefix);
+            return (c != 0) ? (c < 0) : comp(*lhs.obj, rhs);
+         }
+
+         inline bool operator()(const bound_key& lhs, const entry& rhs)const
+         {
+            auto c = key_prefix::compare(prefix, rhs.prefix);
+            return (c != 0) ? (c < 0) : comp(lhs, *rhs.obj);
+         }
+      };
+
+      struct entry_object
+      {
+         inline const dynamic_object& operator()(const entry& e)const { return *e.obj; }
+      };
+
+   public:
+
+      using container_type = bmi::multi_index_container<
+                                entry,
+                                bmi::indexed_by<bmi::ordered_unique<bmi::identity<entry>, entry_compare>>,
+                                counting_allocator<entry>
+                             >;
+      using const_iterator = boost::transform_iterator<entry_object, container_type::const_iterator>;
+
+      // Keys are cached whenever the index allows it, and abbreviated otherwise, unless cache_keys is false.
+      ordered_index(const types_manager::table_index& ti, bool cache_keys = true);
+
+      ordered_index(const ordered_index&) = delete;
+      ordered_index& operator=(const ordered_index&) = delete;
+
+      virtual index_kind            get_kind()const override { return kind; }
+      virtual const dynamic_object* insert(const dynamic_object& o) override;
+      virtual void                  erase(const dynamic_object& o) override;
+      virtual void                  clear() override { objects.clear(); }
+      virtual size_t                size()const override { return objects.size(); }
+      virtual void                  bulk_load(sorted_run& run) override;
+      virtual index_memory_usage    get_memory_usage()const override;
+
+      inline bool           is_caching_keys()const      { return cached_key_size > 0; }
+      inline bool           is_abbreviating_keys()const { return abbreviated_keys; }
+
+      inline const_iterator begin()const { return const_iterator(objects.begin()); }
+      inline const_iterator end()const   { return const_iterator(objects.end()); }
+
+      inline const_iterator iterator_to(const dynamic_object& o)const { return const_iterator(objects.find(make_entry(o))); }
+
+      // Prepares k for repeated lookups in this index (see bound_key). Throws std::invalid_argument if the data of k is malformed.
+      bound_key      bind(const dynamic_key& k)const;
+
+      const_iterator lower_bound(const bound_key& k)const;
+      const_iterator upper_bound(const bound_key& k)const;
+      const_iterator find(const bound_key& k)const;
+
+      inline std::pair<const_iterator, const_iterator> equal_range(const bound_key& k)const { return {lower_bound(k), upper_bound(k)}; }
+
+      inline const_iterator lower_bound(const dynamic_key& k)const { return lower_bound(bind(k)); }
+      inline const_iterator upper_bound(const dynamic_key& k)const { return upper_bound(bind(k)); }
+      inline const_iterator find(const dynamic_key& k)const        { return find(bind(k)); }
+
+      inline std::pair<const_iterator, const_iterator> equal_range(const dynamic_key& k)const { return equal_range(bind(k)); }
+
+      template<typename CompatibleKey, typename CompatibleCompare>
+      inline const_iterator lower_bound(const CompatibleKey& k, const CompatibleCompare& comp)const
+      {
+         return const_iterator(objects.lower_bound(k, object_compare_adapter<CompatibleCompare>{comp}));
+      }
+
+      template<typename CompatibleKey, typename CompatibleCompare>
+      inline const_iterator upper_bound(const CompatibleKey& k, const CompatibleCompare& comp)const
+      {
+         return const_iterator(objects.upper_bound(k, object_compare_adapter<CompatibleCompare>{comp}));
+      }
+
+      template<typename CompatibleKey, typename CompatibleCompare>
+      inline const_iterator find(const CompatibleKey& k, const CompatibleCompare& comp)const
+      {
+         auto itr = lower_bound(k, comp);
+         if( itr == end() || comp(k, *itr) )
+            return end();
+         return itr;
+      }
+
+      template<typename CompatibleKey, typename CompatibleCompare>
+      inline std::pair<const_iterator, const_iterator> equal_range(const CompatibleKey& k, const CompatibleCompare& comp)const
+      {
+         auto r = objects.equal_range(k, object_compare_adapter<CompatibleCompare>{comp});
+         return {const_iterator(r.first), const_iterator(r.second)};
+      }
+
+   private:
+      key_normalizer      normalizer;
+      uint32_t            cached_key_size;
+      bool                abbreviated_keys;
+      uint64_t            allocated_bytes = 0; // By objects (see counting_allocator), so it must come before it
+      container_type      objects;
+      bound_key_compare   key_compare;
+
+      entry make_entry(const dynamic_object& o)const;
+   };
+
+   // Unordered index with exact-match lookups only.
+   // Its key must not contain a rational (nor an Any, which may hold one), since a rational of 0/0 equals every value, which no hash can
+   // be consistent with.
+   class hashed_index : public secondary_index
+   {
+   public:
+
+      static constexpr index_kind kind = index_kind::hashed;
+
+      using container_type = bmi::multi_index_container<
+                                const dynamic_object*,
+                                bmi::indexed_by<bmi::hashed_unique<bmi::identity<const dynamic_object>, dynamic_object_hash, dynamic_object_equal>>,
+                                counting_allocator<const dynamic_object*>
+                             >;
+      using const_iterator = boost::indirect_iterator<container_type::const_iterator>;
+
+      // Throws std::invalid_argument if the key of the index may contain a rational.
+      hashed_index(const types_manager::table_index& ti);
+
+      hashed_index(const hashed_index&) = delete;
+      hashed_index& operator=(const hashed_index&) = delete;
+
+      virtual index_kind            get_kind()const override { return kind; }
+      virtual const dynamic_object* insert(const dynamic_object& o) override;
+      virtual void                  erase(const dynamic_object& o) override;
+      virtual void                  clear() override { objects.clear(); }
+      virtual size_t                size()const override { return objects.size(); }
+      virtual void                  bulk_load(sorted_run& run) override;
+      virtual index_memory_usage    get_memory_usage()const override;
+
+      inline const_iterator begin()const { return const_iterator(objects.begin()); }
+      inline const_iterator end()const   { return const_iterator(objects.end()); }
+
+      inline const_iterator iterator_to(const dynamic_object& o)const { return const_iterator(objects.find(o)); }
+
+      // Throws std::invalid_argument for a key restricted to some of its members, since hashing needs the whole key.
+      const_iterator find(const dynamic_key& k)const;
+
+   private:
+      uint16_t             num_key_members;
+      uint64_t             allocated_bytes = 0; // By objects (see counting_allocator), so it must come before it
+      container_type       objects;
+      dynamic_object_hash  hash;
+      dynamic_object_equal equal;
+   };
+
+} }
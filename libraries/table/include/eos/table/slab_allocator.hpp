@@ -0,0 +1,59 @@
+#pragma once
+
+#include <eos/eoslib/raw_region.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace eos { namespace table {
+
+   using namespace eos::types;
+
+   // Memory for the data of the objects of a table: blocks of a few size classes carved out of large slabs, with a free list per class.
+   // Freed blocks are reused by later allocations of the same class, but slabs are only released when the allocator is destroyed.
+   // Requests larger than max_block_size go straight to operator new.
+   // Not thread-safe: a table allocates and frees the data of its objects only while it is being modified, which is never concurrent.
+   class slab_allocator : public memory_resource
+   {
+   public:
+
+      static constexpr uint32_t slab_size      = 64 * 1024;
+      static constexpr uint32_t max_block_size = 4096;
+      static constexpr uint32_t num_classes    = 28; // Multiples of 16 bytes up to 128, then four classes per doubling up to max_block_size
+
+      slab_allocator() = default;
+
+      slab_allocator(const slab_allocator&) = delete;
+      slab_allocator& operator=(const slab_allocator&) = delete;
+
+      virtual void* allocate(size_t size) override;
+      virtual void  deallocate(void* p, size_t size) override;
+
+      inline size_t get_bytes_in_use()const   { return bytes_in_use; }   // Size of the blocks (and large allocations) currently handed out
+      inline size_t get_bytes_reserved()const { return bytes_reserved; } // Size of the slabs and large allocations currently held
+
+      static uint32_t get_class(size_t size);
+      static uint32_t get_block_size(uint32_t size_class);
+
+   private:
+
+      struct free_block
+      {
+         free_block* next;
+      };
+
+      struct size_class
+      {
+         free_block* free_list = nullptr;
+         byte*       next      = nullptr; // Unused part of the newest slab of the class
+         byte*       end       = nullptr;
+      };
+
+      std::array<size_class, num_classes> classes;
+      std::vector<std::unique_ptr<byte[]>> slabs;
+      size_t                               bytes_in_use   = 0;
+      size_t                               bytes_reserved = 0;
+   };
+
+} }
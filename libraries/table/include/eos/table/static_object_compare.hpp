@@ -0,0 +1,311 @@
+#pragma once
+
+#include <eos/table/dynamic_object.hpp>
+#include <eos/types/reflect.hpp>
+#include <eos/eoslib/compare_kernels.hpp>
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/member.hpp>
+
+namespace bmi = boost::multi_index;
+
+namespace eos { namespace table {
+
+   // Reading and comparing a field of builtin type B at a fixed offset within the data of two objects.
+   // fixed_size is the number of bytes at that offset the field occupies (the header, for strings and bytes).
+   template<type_id::builtin B>
+   struct builtin_field
+   {
+      using is_supported = std::false_type;
+   };
+
+   template<typename T>
+   struct integer_field
+   {
+      using is_supported = std::true_type;
+      static constexpr uint32_t fixed_size = sizeof(T);
+
+      static inline int8_t compare(const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)
+      {
+         return compare_primitives(trusted_region(lhs).get<T>(lhs_offset), trusted_region(rhs).get<T>(rhs_offset));
+      }
+   };
+
+   template<> struct builtin_field<type_id::builtin_int8>   : integer_field<int8_t>   {};
+   template<> struct builtin_field<type_id::builtin_uint8>  : integer_field<uint8_t>  {};
+   template<> struct builtin_field<type_id::builtin_int16>  : integer_field<int16_t>  {};
+   template<> struct builtin_field<type_id::builtin_uint16> : integer_field<uint16_t> {};
+   template<> struct builtin_field<type_id::builtin_int32>  : integer_field<int32_t>  {};
+   template<> struct builtin_field<type_id::builtin_uint32> : integer_field<uint32_t> {};
+   template<> struct builtin_field<type_id::builtin_int64>  : integer_field<int64_t>  {};
+   template<> struct builtin_field<type_id::builtin_uint64> : integer_field<uint64_t> {};
+
+   template<>
+   struct builtin_field<type_id::builtin_bool>
+   {
+      using is_supported = std::true_type;
+      static constexpr uint32_t fixed_size = 1;
+
+      static inline int8_t compare(const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)
+      {
+         return compare_primitives(trusted_region(lhs).get<bool>(lhs_offset << 3), trusted_region(rhs).get<bool>(rhs_offset << 3));
+      }
+   };
+
+   template<>
+   struct builtin_field<type_id::builtin_rational>
+   {
+      using is_supported = std::true_type;
+      static constexpr uint32_t fixed_size = 16;
+
+      static inline int8_t compare(const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)
+      {
+         trusted_region l(lhs), r(rhs);
+         return compare_rationals(l.get<int64_t>(lhs_offset), l.get<uint64_t>(lhs_offset+8), r.get<int64_t>(rhs_offset), r.get<uint64_t>(rhs_offset+8));
+      }
+   };
+
+   struct byte_range_field
+   {
+      using is_supported = std::true_type;
+      static constexpr uint32_t fixed_size = 8;
+
+      static inline int8_t compare(const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)
+      {
+         trusted_region l(lhs), r(rhs);
+         auto lhs_num_elements = l.get<uint32_t>(lhs_offset);
+         auto rhs_num_elements = r.get<uint32_t>(rhs_offset);
+         auto lhs_data_offset  = l.get<uint32_t>(lhs_offset+4);
+         auto rhs_data_offset  = r.get<uint32_t>(rhs_offset+4);
+         uint64_t num_bytes = std::min(lhs_num_elements, rhs_num_elements);
+
+         if( num_bytes > 0 && (lhs_data_offset + num_bytes > lhs.offset_end() || rhs_data_offset + num_bytes > rhs.offset_end()) )
+            throw std::out_of_range("Offset puts type outside of current range.");
+
+         return compare_integer_runs<uint8_t>(l.get_data() + lhs_data_offset, lhs_num_elements, r.get_data() + rhs_data_offset, rhs_num_elements);
+      }
+   };
+
+   template<> struct builtin_field<type_id::builtin_string> : byte_range_field {};
+   template<> struct builtin_field<type_id::builtin_bytes>  : byte_range_field {};
+
+   // Field for a member of C++ type T, which is only supported if T is reflected as a builtin type.
+   template<typename T, typename Enable = void>
+   struct member_field
+   {
+      using is_supported = std::false_type;
+   };
+
+   template<typename T>
+   struct member_field<T, typename std::enable_if<reflector<T>::is_builtin::value>::type> : builtin_field<reflector<T>::builtin_type>
+   {
+      static constexpr type_id::builtin builtin_type = reflector<T>::builtin_type;
+   };
+
+   // Sorted members of a key type, as a tuple of sorted_member_info: the key itself for a builtin key, or the sorted members of a struct key.
+   template<typename Key, typename Enable = void>
+   struct key_members
+   {
+      using is_supported = std::false_type;
+      using type         = std::tuple<>;
+   };
+
+   template<typename Key>
+   struct key_members<Key, typename std::enable_if<reflector<Key>::is_builtin::value>::type>
+   {
+      using is_supported = std::true_type;
+      using type         = std::tuple<sorted_member_info<Key, true>>;
+   };
+
+   template<typename Key>
+   struct key_members<Key, typename std::enable_if<(std::tuple_size<typename reflector<Key>::sorted_members>::value > 0)>::type>
+   {
+      using is_supported = std::true_type;
+      using type         = typename reflector<Key>::sorted_members;
+   };
+
+   template<typename Members>
+   struct all_members_supported;
+
+   template<typename... Members>
+   struct all_members_supported<std::tuple<Members...>>
+   {
+      static constexpr bool all()
+      {
+         bool supported[] = { true, member_field<typename Members::type>::is_supported::value... };
+         for( bool s : supported )
+            if( !s ) return false;
+         return true;
+      }
+
+      using type = std::integral_constant<bool, all()>;
+   };
+
+   // Comparator of objects for an index described at compile time by an index_reflector (see table_reflector<T>::indices), for keys made
+   // only of builtin members. It reads each member at its offset (taken from the types_manager when constructed) with a comparison known at
+   // compile time, rather than interpreting the layout. The constructor checks the compile-time description against the table_index.
+   template<typename IndexReflector>
+   class static_object_compare
+   {
+      using members = typename key_members<typename IndexReflector::key_type>::type;
+
+      static constexpr size_t num_members = std::tuple_size<members>::value;
+
+   public:
+
+      using is_supported = std::integral_constant<bool, key_members<typename IndexReflector::key_type>::is_supported::value
+                                                        && all_members_supported<members>::type::value>;
+
+      static_object_compare(const types_manager::table_index& ti)
+         : stats(ti)
+      {
+         static_assert( is_supported::value, "Key of index has members that are not builtin types" );
+
+         if( ti.is_unique() != IndexReflector::is_unique::value || ti.is_ascending() != IndexReflector::is_ascending::value )
+            throw std::runtime_error("Static comparator does not match the kind of the index");
+
+         auto sorted_members = ti.get_sorted_members();
+         if( static_cast<size_t>(sorted_members.end() - sorted_members.begin()) != num_members )
+            throw std::runtime_error("Static comparator does not match the number of sorted members of the key of the index");
+
+         min_size = 0;
+         init(sorted_members.begin(), std::make_index_sequence<num_members>());
+      }
+
+      inline bool operator()(const dynamic_object& lhs, const dynamic_object& rhs)const
+      {
+         EOS_TYPES_COMPARE_STATS_SCOPE(stats.get(), false);
+
+         if( lhs.data.offset_end() < min_size || rhs.data.offset_end() < min_size )
+            throw std::out_of_range("Object data is too small for the key of the index");
+
+         auto c = compare_members(lhs.data, rhs.data, std::make_index_sequence<num_members>());
+         if( c == 0 && !IndexReflector::is_unique::value )
+            c = compare_primitives(lhs.id, rhs.id);
+         return (c < 0);
+      }
+
+   private:
+
+      template<size_t I>
+      using member_at = typename std::tuple_element<I, members>::type;
+
+      template<size_t I>
+      using field_at  = member_field<typename member_at<I>::type>;
+
+      template<size_t I>
+      static constexpr bool is_ascending_at()
+      {
+         return (member_at<I>::is_ascending::value == IndexReflector::is_ascending::value);
+      }
+
+      template<typename Iterator, size_t... I>
+      void init(Iterator itr, std::index_sequence<I...>)
+      {
+         bool ok[] = { true, check_member<I>(*(itr + I))... };
+         (void)ok;
+      }
+
+      template<size_t I>
+      bool check_member(const field_metadata& f)
+      {
+         if( !(f.get_type_id() == type_id(field_at<I>::builtin_type)) )
+            throw std::runtime_error("Static comparator does not match the type of a sorted member of the key of the index");
+         if( (f.get_sort_order() == field_metadata::ascending) != member_at<I>::is_ascending::value )
+            throw std::runtime_error("Static comparator does not match the sort order of a sorted member of the key of the index");
+
+         offsets[I] = f.get_offset();
+         min_size   = std::max(min_size, offsets[I] + field_at<I>::fixed_size);
+         return true;
+      }
+
+      template<size_t... I>
+      inline int8_t compare_members(const raw_region& lhs, const raw_region& rhs, std::index_sequence<I...>)const
+      {
+         int8_t c = 0;
+         bool done[] = { false, (c == 0 && (c = compare_member<I>(lhs, rhs)) != 0)... }; // Stops comparing at the first difference
+         (void)done;
+         return c;
+      }
+
+      template<size_t I>
+      inline int8_t compare_member(const raw_region& lhs, const raw_region& rhs)const
+      {
+         auto c = field_at<I>::compare(lhs, offsets[I], rhs, offsets[I]);
+         return (is_ascending_at<I>() ? c : -c);
+      }
+
+      std::array<uint32_t, num_members> offsets;
+      uint32_t                          min_size;
+      compare_stats_ref                 stats;
+   };
+
+   // Comparator used by static_dynamic_table for an index: static_object_compare if it supports the key, otherwise dynamic_object_compare.
+   template<typename IndexReflector>
+   using static_index_compare = typename std::conditional<static_object_compare<IndexReflector>::is_supported::value,
+                                                          static_object_compare<IndexReflector>,
+                                                          dynamic_object_compare>::type;
+
+   template<typename Indices>
+   struct static_dynamic_table_type;
+
+   template<typename... Indices>
+   struct static_dynamic_table_type<std::tuple<Indices...>>
+   {
+      using type = bmi::multi_index_container<
+                      dynamic_object,
+                      bmi::indexed_by<
+                         bmi::ordered_unique<bmi::member<dynamic_object, uint64_t, &dynamic_object::id>>,
+                         bmi::ordered_unique<bmi::identity<dynamic_object>, static_index_compare<Indices>>...
+                      >
+                   >;
+   };
+
+   // Same as dynamic_table_N, for a table T reflected with EOS_TYPES_CREATE_TABLE, but with comparators specialized at compile time
+   // for the key of each index (see static_object_compare).
+   // Its constructor arguments are not built through boost::make_tuple, so it is not limited to 9 indices like dynamic_table_N.
+   template<typename T>
+   using static_dynamic_table = typename static_dynamic_table_type<typename table_reflector<T>::indices>::type;
+
+   template<typename CtorArgs>
+   struct static_dynamic_table_ctor_args;
+
+   template<>
+   struct static_dynamic_table_ctor_args<boost::tuples::null_type>
+   {
+      static boost::tuples::null_type make(const types_manager&, type_id::index_t, uint8_t) { return boost::tuples::null_type(); }
+   };
+
+   template<typename Head, typename Tail>
+   struct static_dynamic_table_ctor_args<boost::tuples::cons<Head, Tail>>
+   {
+      static boost::tuples::cons<Head, Tail> make(const types_manager& tm, type_id::index_t tbl_indx, uint8_t index_seq_num)
+      {
+         using compare_type = typename boost::tuples::element<1, Head>::type;
+         return boost::tuples::cons<Head, Tail>(Head(bmi::identity<dynamic_object>(), compare_type(tm.get_table_index(tbl_indx, index_seq_num))),
+                                                static_dynamic_table_ctor_args<Tail>::make(tm, tbl_indx, index_seq_num + 1));
+      }
+   };
+
+   template<typename T>
+   typename static_dynamic_table<T>::ctor_args_list
+   make_static_dynamic_table_ctor_args_list(const types_manager& tm, type_id::index_t tbl_indx)
+   {
+      using table_type = static_dynamic_table<T>;
+      using args_type  = typename table_type::ctor_args_list;
+
+      if( tm.get_num_indices_in_table(tbl_indx) != std::tuple_size<typename table_reflector<T>::indices>::value )
+         throw std::runtime_error("Mismatch between run-time and compile-time evaluation of the number of indices in the table.");
+
+      return args_type(typename table_type::template nth_index<0>::type::ctor_args(),
+                       static_dynamic_table_ctor_args<typename args_type::tail_type>::make(tm, tbl_indx, 0));
+   }
+
+} }
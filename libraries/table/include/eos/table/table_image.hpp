@@ -0,0 +1,116 @@
+#pragma once
+
+#include <eos/table/dynamic_object.hpp>
+#include <eos/eoslib/type_id.hpp>
+#include <eos/types/types_manager.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string>
+#include <vector>
+
+namespace eos { namespace table {
+
+   using namespace eos::types;
+
+   // File holding the objects of a dynamic_table in id order, together with a description of each of its indices and, optionally, the order
+   // of the objects in each ordered index (see dynamic_table::save and dynamic_table::load). It is written sequentially and memory-mapped when
+   // read. Everything in it is referred to by its offset from the start of the file, so the file can be mapped at any address.
+   //
+   // Layout, with every integer in the byte order of the machine that wrote it and every section aligned to 8 bytes:
+   //    header
+   //    index_info indices[num_indices]
+   //    uint64_t   object_offsets[num_objects]  Offset of each object record
+   //    object records                         uint64_t id, uint32_t size, uint32_t (zero), then size bytes of data
+   //    orders                                 uint64_t positions[num_objects] per kept order: positions in object_offsets, in index order
+   class table_image
+   {
+   public:
+
+      static const uint64_t magic   = 0x31454c4241544f45ull; // "EOTABLE1" when read as little-endian
+      static const uint32_t version = 2;
+
+      struct header
+      {
+         uint64_t magic;
+         uint32_t version;
+         uint32_t table;
+         uint64_t fingerprint; // See types_manager::get_fingerprint
+         uint64_t num_objects;
+         uint64_t num_indices;
+      };
+
+      struct index_info
+      {
+         enum flags : uint32_t
+         {
+            unique    = 1,
+            ascending = 2,
+            hashed    = 4
+         };
+
+         uint64_t order_offset; // Offset of the order of the index, or 0 if it is not kept
+         uint32_t key_type;     // Storage of the type_id of the key of the index
+         uint32_t flags;
+
+         static index_info describe(const types_manager::table_index& ti);
+
+         // Whether the description matches ti, ignoring whether an order is kept.
+         inline bool matches(const types_manager::table_index& ti)const
+         {
+            auto d = describe(ti);
+            return key_type == d.key_type && flags == d.flags;
+         }
+      };
+
+      struct object_view
+      {
+         uint64_t    id;
+         const byte* data;
+         uint32_t    size;
+      };
+
+      // Maps the image at path. Throws std::runtime_error if it cannot be mapped or its header is malformed.
+      explicit table_image(const std::string& path);
+
+      table_image(const table_image&) = delete;
+      table_image& operator=(const table_image&) = delete;
+
+      inline uint64_t         get_fingerprint()const { return get_header().fingerprint; }
+      inline type_id::index_t get_table()const       { return get_header().table; }
+      inline uint64_t         size()const            { return get_header().num_objects; }
+      inline uint64_t         get_num_indices()const { return get_header().num_indices; }
+
+      const index_info& get_index_info(uint8_t index_seq_num)const;
+
+      // Throws std::runtime_error if the record of the object lies outside of the image.
+      object_view     get_object(uint64_t pos)const;
+
+      // Positions of the objects in the order of the index index_seq_num, or nullptr if the image does not keep it.
+      // The positions themselves are not checked. Throws std::runtime_error if the order lies outside of the image.
+      const uint64_t* get_order(uint8_t index_seq_num)const;
+
+      // Writes an image of objects, which must be in id order, for the table tbl_indx of a types_manager with the given fingerprint.
+      // indices describes each index of the table (their order_offset is ignored), and orders has one entry per index: the positions within
+      // objects of the objects in the order of the index, or nothing if that order is not kept. The image is written to a temporary file that
+      // is flushed to disk and then renamed to path (after which the directory is flushed too), so an existing image at path is replaced only
+      // once the new one is complete, even across a crash. Throws std::runtime_error if the file cannot be written.
+      static void     write(const std::string& path, uint64_t fingerprint, type_id::index_t tbl_indx, const std::vector<index_info>& indices,
+                            const std::vector<const dynamic_object*>& objects, const std::vector<std::vector<uint64_t>>& orders);
+
+   private:
+
+      boost::interprocess::file_mapping  mapping;
+      boost::interprocess::mapped_region region;
+      const byte*                        data;
+      uint64_t                           data_size;
+
+      inline const header& get_header()const { return *reinterpret_cast<const header*>(data); }
+
+      uint64_t read_offset(uint64_t offset)const; // Throws std::runtime_error if offset is out of bounds
+
+      inline uint64_t get_objects_offset()const { return sizeof(header) + sizeof(index_info) * get_num_indices(); }
+   };
+
+} }
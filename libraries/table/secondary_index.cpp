@@ -0,0 +1,177 @@
+#include <eos/table/secondary_index.hpp>
+
+#include <stdexcept>
+
+namespace eos { namespace table {
+
+   constexpr index_kind ordered_index::kind;
+   constexpr uint32_t   ordered_index::max_cached_key_size;
+
+   namespace {
+      uint32_t cached_key_size_of(const key_normalizer& normalizer, bool cache_keys)
+      {
+         auto size = normalizer.get_object_key_size();
+         return (cache_keys && size <= ordered_index::max_cached_key_size) ? size : 0;
+      }
+   }
+
+   ordered_index::ordered_index(const types_manager::table_index& ti, bool cache_keys)
+      : normalizer(ti), cached_key_size(cached_key_size_of(normalizer, cache_keys)), abbreviated_keys(cache_keys && cached_key_size == 0),
+        objects(boost::make_tuple(boost::make_tuple(bmi::identity<entry>(), entry_compare(ti, cached_key_size, abbreviated_keys))),
+                counting_allocator<entry>(&allocated_bytes)),
+        key_compare(ti, true)
+   {
+   }
+
+   ordered_index::entry ordered_index::make_entry(const dynamic_object& o)const
+   {
+      entry e;
+      e.obj = &o;
+      if( cached_key_size > 0 )
+      {
+         auto nk = normalizer(o);
+         std::memcpy(e.key, nk.data.data(), cached_key_size);
+      }
+      else if( abbreviated_keys )
+         e.prefix = key_prefix(normalizer(o));
+      return e;
+   }
+
+   const dynamic_object* ordered_index::insert(const dynamic_object& o)
+   {
+      auto res = objects.insert(make_entry(o));
+      if( res.second )
+         return nullptr;
+      return res.first->obj;
+   }
+
+   void ordered_index::erase(const dynamic_object& o)
+   {
+      auto itr = objects.find(make_entry(o));
+      if( itr != objects.end() && itr->obj == &o )
+         objects.erase(itr);
+   }
+
+   void ordered_index::bulk_load(sorted_run& run)
+   {
+      for( const auto& p : run )
+      {
+         entry e;
+         e.obj = p.second;
+         if( cached_key_size > 0 )
+            std::memcpy(e.key, p.first.data.data(), cached_key_size);
+         else if( abbreviated_keys )
+            e.prefix = key_prefix(p.first);
+         objects.insert(objects.end(), e); // Amortized constant time since the hint is exact
+      }
+   }
+
+   index_memory_usage ordered_index::get_memory_usage()const
+   {
+      index_memory_usage u;
+      u.kind       = kind;
+      u.nodes      = objects.size();
+      u.node_bytes = allocated_bytes;
+      return u;
+   }
+
+   bound_key ordered_index::bind(const dynamic_key& k)const
+   {
+      auto b = key_compare.bind(k);
+      if( cached_key_size > 0 || abbreviated_keys )
+         b.normalized = normalizer(k);
+      return b;
+   }
+
+   ordered_index::const_iterator ordered_index::lower_bound(const bound_key& k)const
+   {
+      if( cached_key_size > 0 )
+         return const_iterator(objects.lower_bound(k.normalized, cached_key_compare()));
+      if( abbreviated_keys )
+         return const_iterator(objects.lower_bound(k, abbreviated_key_compare{key_prefix(k.normalized), key_compare}));
+      return const_iterator(objects.lower_bound(k, object_compare_adapter<bound_key_compare>{key_compare}));
+   }
+
+   ordered_index::const_iterator ordered_index::upper_bound(const bound_key& k)const
+   {
+      if( cached_key_size > 0 )
+         return const_iterator(objects.upper_bound(k.normalized, cached_key_compare()));
+      if( abbreviated_keys )
+         return const_iterator(objects.upper_bound(k, abbreviated_key_compare{key_prefix(k.normalized), key_compare}));
+      return const_iterator(objects.upper_bound(k, object_compare_adapter<bound_key_compare>{key_compare}));
+   }
+
+   ordered_index::const_iterator ordered_index::find(const bound_key& k)const
+   {
+      auto itr = lower_bound(k);
+      if( itr == end() || key_compare(k, *itr) )
+         return end();
+      return itr;
+   }
+
+   constexpr index_kind hashed_index::kind;
+
+   namespace {
+      // Number of sorted members of the key of ti. Throws std::invalid_argument if the key may contain a rational: either directly, or
+      // within an Any. Recursive types need no special care, since their members have been compiled before the recursion is reached.
+      uint16_t hashable_key_members(const types_manager::table_index& ti)
+      {
+         compare_program key_program(ti, compare_program::key_view);
+         for( const auto& s : key_program.get_steps() )
+         {
+            bool is_any = ( s.op == compare_program::op_interpret && type_id(s.arg).get_type_class() == type_id::builtin_type
+                            && type_id(s.arg).get_builtin_type() == type_id::builtin_any );
+            if( s.op == compare_program::op_rational || is_any )
+               throw std::invalid_argument("Key of a hashed index cannot contain a rational");
+         }
+         return key_program.get_num_members();
+      }
+   }
+
+   hashed_index::hashed_index(const types_manager::table_index& ti)
+      : num_key_members(hashable_key_members(ti)),
+        objects(boost::make_tuple(boost::make_tuple(0, bmi::identity<const dynamic_object>(), dynamic_object_hash(ti), dynamic_object_equal(ti, true))),
+                counting_allocator<const dynamic_object*>(&allocated_bytes)),
+        hash(ti), equal(ti)
+   {
+   }
+
+   const dynamic_object* hashed_index::insert(const dynamic_object& o)
+   {
+      auto res = objects.insert(&o);
+      if( res.second )
+         return nullptr;
+      return *res.first;
+   }
+
+   hashed_index::const_iterator hashed_index::find(const dynamic_key& k)const
+   {
+      if( k.num_members < num_key_members )
+         throw std::invalid_argument("Hashed index cannot look up a key restricted to some of its members");
+      return const_iterator(objects.find(k, hash, equal));
+   }
+
+   void hashed_index::bulk_load(sorted_run& run)
+   {
+      objects.reserve(run.size());
+      for( const auto& p : run )
+         objects.insert(p.second);
+   }
+
+   index_memory_usage hashed_index::get_memory_usage()const
+   {
+      index_memory_usage u;
+      u.kind       = kind;
+      u.nodes      = objects.size();
+      u.node_bytes = allocated_bytes;
+      return u;
+   }
+
+   void hashed_index::erase(const dynamic_object& o)
+   {
+      auto itr = objects.find(o);
+      if( itr != objects.end() && *itr == &o )
+         objects.erase(itr);
+   }
+
+} }
@@ -0,0 +1,83 @@
+#include <eos/table/slab_allocator.hpp>
+
+#include <new>
+
+namespace eos { namespace table {
+
+   constexpr uint32_t slab_allocator::slab_size;
+   constexpr uint32_t slab_allocator::max_block_size;
+   constexpr uint32_t slab_allocator::num_classes;
+
+   uint32_t slab_allocator::get_class(size_t size)
+   {
+      if( size <= 128 )
+         return (size <= 16) ? 0 : static_cast<uint32_t>((size + 15) / 16 - 1);
+
+      // Sizes in (2^k, 2^(k+1)] for k >= 7 are split into four classes of 2^(k-2) bytes each.
+      uint32_t k = 63 - __builtin_clzll(static_cast<uint64_t>(size - 1));
+      return 8 + (k - 7) * 4 + static_cast<uint32_t>((size - 1) >> (k - 2)) - 4;
+   }
+
+   uint32_t slab_allocator::get_block_size(uint32_t size_class)
+   {
+      if( size_class < 8 )
+         return (size_class + 1) * 16;
+
+      uint32_t k = 7 + (size_class - 8) / 4;
+      return (1u << k) + ((size_class - 8) % 4 + 1) * (1u << (k - 2));
+   }
+
+   void* slab_allocator::allocate(size_t size)
+   {
+      if( size > max_block_size )
+      {
+         bytes_in_use   += size;
+         bytes_reserved += size;
+         return ::operator new(size);
+      }
+
+      auto  c          = get_class(size);
+      auto  block_size = get_block_size(c);
+      auto& sc         = classes[c];
+      bytes_in_use += block_size;
+
+      if( sc.free_list != nullptr )
+      {
+         auto b = sc.free_list;
+         sc.free_list = b->next;
+         return b;
+      }
+
+      if( sc.next == sc.end )
+      {
+         slabs.emplace_back(new byte[slab_size]);
+         bytes_reserved += slab_size;
+         sc.next = slabs.back().get();
+         sc.end  = sc.next + (slab_size / block_size) * block_size;
+      }
+
+      auto b = sc.next;
+      sc.next += block_size;
+      return b;
+   }
+
+   void slab_allocator::deallocate(void* p, size_t size)
+   {
+      if( size > max_block_size )
+      {
+         bytes_in_use   -= size;
+         bytes_reserved -= size;
+         ::operator delete(p);
+         return;
+      }
+
+      auto  c  = get_class(size);
+      auto& sc = classes[c];
+      bytes_in_use -= get_block_size(c);
+
+      auto b = static_cast<free_block*>(p);
+      b->next = sc.free_list;
+      sc.free_list = b;
+   }
+
+} }
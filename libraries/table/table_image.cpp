@@ -0,0 +1,216 @@
+#include <eos/table/table_image.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace eos { namespace table {
+
+   const uint64_t table_image::magic;
+   const uint32_t table_image::version;
+
+   namespace {
+
+      static_assert( sizeof(table_image::header) == 40 && sizeof(table_image::index_info) == 16, "Layout of table images must not depend on padding" );
+
+      const uint64_t record_header_size = 16;
+
+      inline uint64_t padded(uint64_t size)
+      {
+         return (size + 7) & ~static_cast<uint64_t>(7);
+      }
+
+      // Flushes the file (or directory) at path to disk.
+      bool sync_path(const std::string& path)
+      {
+         int fd = ::open(path.c_str(), O_RDONLY);
+         if( fd < 0 )
+            return false;
+         bool ok = (::fsync(fd) == 0);
+         ::close(fd);
+         return ok;
+      }
+
+      inline std::string directory_of(const std::string& path)
+      {
+         auto pos = path.rfind('/');
+         if( pos == std::string::npos )
+            return ".";
+         return (pos == 0 ? "/" : path.substr(0, pos));
+      }
+
+      template<typename T>
+      inline void write_value(std::ofstream& out, const T& v)
+      {
+         out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+      }
+
+   }
+
+   table_image::table_image(const std::string& path)
+   {
+      namespace bip = boost::interprocess;
+      try
+      {
+         mapping = bip::file_mapping(path.c_str(), bip::read_only);
+         region  = bip::mapped_region(mapping, bip::read_only);
+      }
+      catch( const bip::interprocess_exception& e )
+      {
+         throw std::runtime_error(std::string("Cannot map table image: ") + e.what());
+      }
+
+      data      = static_cast<const byte*>(region.get_address());
+      data_size = region.get_size();
+
+      if( data_size < sizeof(header) || get_header().magic != magic )
+         throw std::runtime_error("File is not a table image");
+      if( get_header().version != version )
+         throw std::runtime_error("Table image has an unsupported version");
+
+      const auto& h = get_header();
+      if( h.num_indices > 255 || h.num_objects > (data_size - sizeof(header)) / 8
+          || get_objects_offset() + 8 * h.num_objects > data_size )
+         throw std::runtime_error("Table image is malformed");
+   }
+
+   table_image::index_info table_image::index_info::describe(const types_manager::table_index& ti)
+   {
+      index_info info;
+      info.order_offset = 0;
+      info.key_type     = ti.get_key_type().get_storage();
+      info.flags        = (ti.is_unique() ? unique : 0) | (ti.is_ascending() ? ascending : 0) | (ti.is_hashed() ? hashed : 0);
+      return info;
+   }
+
+   const table_image::index_info& table_image::get_index_info(uint8_t index_seq_num)const
+   {
+      if( index_seq_num >= get_num_indices() )
+         throw std::out_of_range("Table image does not have an index with the given sequence number");
+      return reinterpret_cast<const index_info*>(data + sizeof(header))[index_seq_num];
+   }
+
+   uint64_t table_image::read_offset(uint64_t offset)const
+   {
+      if( offset > data_size - 8 )
+         throw std::runtime_error("Table image is malformed");
+      uint64_t v;
+      std::memcpy(&v, data + offset, 8);
+      return v;
+   }
+
+   table_image::object_view table_image::get_object(uint64_t pos)const
+   {
+      if( pos >= size() )
+         throw std::out_of_range("Position is past the objects of the table image");
+
+      auto offset = read_offset(get_objects_offset() + 8 * pos);
+      if( offset % 8 != 0 || offset > data_size - record_header_size )
+         throw std::runtime_error("Table image is malformed");
+
+      object_view v;
+      std::memcpy(&v.id,   data + offset,     8);
+      std::memcpy(&v.size, data + offset + 8, 4);
+      if( v.size > data_size - offset - record_header_size )
+         throw std::runtime_error("Table image is malformed");
+      v.data = data + offset + record_header_size;
+      return v;
+   }
+
+   const uint64_t* table_image::get_order(uint8_t index_seq_num)const
+   {
+      auto offset = get_index_info(index_seq_num).order_offset;
+      if( offset == 0 )
+         return nullptr;
+      if( offset % 8 != 0 || offset > data_size || size() > (data_size - offset) / 8 )
+         throw std::runtime_error("Table image is malformed");
+      return reinterpret_cast<const uint64_t*>(data + offset);
+   }
+
+   void table_image::write(const std::string& path, uint64_t fingerprint, type_id::index_t tbl_indx, const std::vector<index_info>& indices,
+                           const std::vector<const dynamic_object*>& objects, const std::vector<std::vector<uint64_t>>& orders)
+   {
+      if( indices.size() > 255 )
+         throw std::invalid_argument("Too many indices for a table image");
+      if( orders.size() != indices.size() )
+         throw std::invalid_argument("Orders do not match the indices");
+
+      header h;
+      h.magic       = magic;
+      h.version     = version;
+      h.table       = tbl_indx;
+      h.fingerprint = fingerprint;
+      h.num_objects = objects.size();
+      h.num_indices = indices.size();
+
+      // All offsets are known before anything is written, so the image is written front to back in one pass.
+      uint64_t offset = sizeof(header) + sizeof(index_info) * indices.size() + 8 * objects.size();
+      std::vector<uint64_t> object_offsets;
+      object_offsets.reserve(objects.size());
+      for( auto o : objects )
+      {
+         object_offsets.push_back(offset);
+         offset += record_header_size + padded(o->data.offset_end());
+      }
+
+      auto infos = indices;
+      for( size_t i = 0; i < orders.size(); ++i )
+      {
+         infos[i].order_offset = 0;
+         if( orders[i].empty() )
+            continue;
+         if( orders[i].size() != objects.size() )
+            throw std::invalid_argument("Order of an index does not cover the objects");
+         infos[i].order_offset = offset;
+         offset += 8 * orders[i].size();
+      }
+
+      auto temp_path = path + ".tmp";
+      {
+         std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+         if( !out )
+            throw std::runtime_error("Cannot create table image");
+
+         write_value(out, h);
+         out.write(reinterpret_cast<const char*>(infos.data()), sizeof(index_info) * infos.size());
+         out.write(reinterpret_cast<const char*>(object_offsets.data()), 8 * object_offsets.size());
+
+         const char zeros[8] = {};
+         for( auto o : objects )
+         {
+            uint32_t size     = o->data.offset_end();
+            uint32_t reserved = 0;
+            write_value(out, o->id);
+            write_value(out, size);
+            write_value(out, reserved);
+            out.write(reinterpret_cast<const char*>(o->data.get_raw_data().data()), size);
+            out.write(zeros, padded(size) - size);
+         }
+
+         for( const auto& order : orders )
+            out.write(reinterpret_cast<const char*>(order.data()), 8 * order.size());
+
+         out.close();
+         if( !out || !sync_path(temp_path) )
+         {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("Cannot write table image");
+         }
+      }
+
+      if( std::rename(temp_path.c_str(), path.c_str()) != 0 )
+      {
+         std::remove(temp_path.c_str());
+         throw std::runtime_error("Cannot replace table image");
+      }
+
+      // The rename itself only lasts through a crash once the directory holding the image is flushed as well.
+      if( !sync_path(directory_of(path)) )
+         throw std::runtime_error("Cannot flush the directory of the table image");
+   }
+
+} }
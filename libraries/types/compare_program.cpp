@@ -0,0 +1,679 @@
+#include <eos/eoslib/compare_program.hpp>
+#include <eos/eoslib/compare_kernels.hpp>
+#include <eos/eoslib/key_encoding.hpp>
+#include <eos/eoslib/exceptions.hpp>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace eos { namespace types {
+
+   compare_program::compare_program(const types_manager_common::table_index& ti, view v)
+      : tm(ti.get_types_manager()), unique(ti.is_unique())
+   {
+      vector<type_id::index_t> struct_stack;
+      bool index_ascending = ti.is_ascending();
+      auto key_type = ti.get_key_type();
+
+      if( v == key_view && key_type.get_type_class() == type_id::builtin_type )
+      {
+         compile_type(key_type, 0, index_ascending, struct_stack); 
+         member_ends.push_back(steps.size());
+         return;
+      }
+
+      auto members = ( v == key_view ? tm.get_sorted_members(key_type.get_type_index()) : ti.get_sorted_members() );
+      for( auto f : members )
+      {
+         compile_type(f.get_type_id(), f.get_offset(), (f.get_sort_order() == field_metadata::ascending) == index_ascending, struct_stack);
+         member_ends.push_back(steps.size());
+      }
+   }
+
+   compare_program::compare_program(const types_manager_common& tm, type_id tid)
+      : tm(tm), unique(true)
+   {
+      vector<type_id::index_t> struct_stack;
+      compile_type(tid, 0, true, struct_stack);
+   }
+
+   void compare_program::add_step(opcode op, uint32_t offset, bool ascending, uint32_t arg, uint32_t arg2)
+   {
+      uint32_t index = steps.size();
+      steps.push_back(step{ .offset = offset, .op = op, .ascending = ascending, .arg = arg, .arg2 = arg2, .next = index + 1 });
+   }
+
+   void compare_program::compile_type(type_id tid, uint32_t offset, bool ascending, vector<type_id::index_t>& struct_stack)
+   {
+      if( tid.is_void() )
+         EOS_ERROR(std::runtime_error, "Invariant failure: Void type should not be allowed in structs or table keys.");
+
+      switch( tid.get_type_class() )
+      {
+         case type_id::builtin_type:
+         {
+            auto b = tid.get_builtin_type();
+            switch( b )
+            {
+               case type_id::builtin_string:
+               case type_id::builtin_bytes:
+                  add_step(op_bytes, offset, ascending);
+                  break;
+               case type_id::builtin_rational:
+                  add_step(op_rational, offset, ascending);
+                  break;
+               case type_id::builtin_any:
+                  add_step(op_interpret, offset, ascending, tid.get_storage());
+                  break;
+               default: // op_int8 through op_bool share the numbering of the corresponding builtins.
+                  add_step(static_cast<opcode>(b), offset, ascending);
+                  break;
+            }
+            return;
+         }
+         case type_id::struct_type:
+         {
+            auto index = tid.get_type_index();
+            if( std::find(struct_stack.begin(), struct_stack.end(), index) != struct_stack.end() )
+            {
+               // Recursive type (e.g. a struct containing a vector of itself). Cannot be flattened, so leave it to the interpreter.
+               add_step(op_interpret, offset, ascending, tid.get_storage());
+               return;
+            }
+            struct_stack.push_back(index);
+            for( auto f : tm.get_sorted_members(index) )
+               compile_type(f.get_type_id(), offset + f.get_offset(), (f.get_sort_order() == field_metadata::ascending) == ascending, struct_stack);
+            struct_stack.pop_back();
+            return;
+         }
+         case type_id::small_array_of_builtins_type:
+         case type_id::small_array_type:
+         case type_id::array_type:
+         {
+            auto res = tm.get_container_element_type(tid);
+            auto sa  = tm.get_size_align(res.first);
+            if( sa.get_align() == 0 ) // Arrays of bools are bit-packed. 
+            {
+               add_step(op_interpret, offset, ascending, tid.get_storage());
+               return;
+            }
+            uint32_t index = steps.size();
+            add_step(op_array, offset, ascending, sa.get_stride(), res.second);
+            compile_type(res.first, 0, ascending, struct_stack);
+            steps[index].next = steps.size();
+            return;
+         }
+         case type_id::vector_type:
+         case type_id::vector_of_something_type:
+         {
+            type_id element_type = ( tid.get_type_class() == type_id::vector_type ? type_id(tm.types[tid.get_type_index()])
+                                                                                  : tid.get_element_type() );
+            auto sa = tm.get_size_align(element_type);
+            if( sa.get_align() == 0 ) // Vectors of bools
+            {
+               add_step(op_interpret, offset, ascending, tid.get_storage());
+               return;
+            }
+            uint32_t index = steps.size();
+            add_step(op_vector, offset, ascending, sa.get_stride(), sa.get_align());
+            compile_type(element_type, 0, ascending, struct_stack);
+            steps[index].next = steps.size();
+            return;
+         }
+         case type_id::optional_struct_type:
+         {
+            uint32_t index = steps.size();
+            add_step(op_optional, offset, ascending, tm.get_optional_tag_offset(tid));
+            compile_type(tid.get_element_type(), 0, ascending, struct_stack);
+            steps[index].next = steps.size();
+            return;
+         }
+         case type_id::variant_or_optional_type:
+         {
+            auto type_index = tid.get_type_index();
+            auto n = tm.types[type_index + 1];
+            uint32_t index = steps.size();
+            if( n >= type_id::variant_case_limit ) // If actually an optional
+            {
+               add_step(op_optional, offset, ascending, tm.get_optional_tag_offset(tid));
+               compile_type(type_id(n), 0, ascending, struct_stack);
+               steps[index].next = steps.size();
+               return;
+            }
+
+            uint32_t cases_index = case_starts.size();
+            add_step(op_variant, offset, ascending, tm.get_variant_tag_offset(tid), cases_index);
+            case_starts.resize(cases_index + n + 2);
+            case_starts[cases_index] = n;
+            for( uint32_t i = 0; i < n; ++i )
+            {
+               case_starts[cases_index + 1 + i] = steps.size();
+               compile_type(type_id(tm.types[type_index + 2 + i]), 0, ascending, struct_stack);
+            }
+            case_starts[cases_index + 1 + n] = steps.size();
+            steps[index].next = steps.size();
+            return;
+         }
+      }
+   }
+
+   inline void check_byte_range(const raw_region& r, uint32_t data_offset, uint64_t num_bytes)
+   {
+      if( num_bytes > 0 && data_offset + num_bytes > r.offset_end() )
+         EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
+   }
+
+   inline void check_byte_range(const trusted_region&, uint32_t, uint64_t) {}
+
+   inline const byte*       data_of(const raw_region& r)       { return r.get_raw_data().data(); }
+   inline const byte*       data_of(const trusted_region& r)   { return r.get_data(); }
+   inline const raw_region& region_of(const raw_region& r)     { return r; }
+   inline const raw_region& region_of(const trusted_region& r) { return r.get_region(); }
+
+   // Compares the strings, bytes or vectors of the builtin integer type b whose headers are at lhs_offset and rhs_offset.
+   template<typename Region>
+   inline int8_t compare_integer_runs_at(type_id::builtin b, const Region& lhs, uint32_t lhs_offset, const Region& rhs, uint32_t rhs_offset)
+   {
+      auto lhs_num_elements = lhs.template get<uint32_t>(lhs_offset);
+      auto rhs_num_elements = rhs.template get<uint32_t>(rhs_offset);
+      auto lhs_data_offset  = lhs.template get<uint32_t>(lhs_offset+4);
+      auto rhs_data_offset  = rhs.template get<uint32_t>(rhs_offset+4);
+      uint64_t num_bytes = static_cast<uint64_t>(std::min(lhs_num_elements, rhs_num_elements)) * get_builtin_integer_size(b);
+
+      check_byte_range(lhs, lhs_data_offset, num_bytes);
+      check_byte_range(rhs, rhs_data_offset, num_bytes);
+
+      return compare_builtin_integer_runs(b, data_of(lhs) + lhs_data_offset, lhs_num_elements, data_of(rhs) + rhs_data_offset, rhs_num_elements);
+   }
+
+   // Builtin integer type of the elements of a vector step whose element program is a single integer step, otherwise builtin_bool.
+   inline type_id::builtin get_integer_element_type(const compare_program::step& element_step, bool single_step)
+   {
+      if( !single_step || element_step.offset != 0 )
+         return type_id::builtin_bool;
+      switch( element_step.op )
+      {
+         case compare_program::op_int8:   return type_id::builtin_int8;
+         case compare_program::op_uint8:  return type_id::builtin_uint8;
+         case compare_program::op_int16:  return type_id::builtin_int16;
+         case compare_program::op_uint16: return type_id::builtin_uint16;
+         case compare_program::op_int32:  return type_id::builtin_int32;
+         case compare_program::op_uint32: return type_id::builtin_uint32;
+         case compare_program::op_int64:  return type_id::builtin_int64;
+         case compare_program::op_uint64: return type_id::builtin_uint64;
+         default:                         return type_id::builtin_bool;
+      }
+   }
+
+   template<typename Region>
+   int8_t compare_program::run(uint32_t begin, uint32_t end, const Region& lhs, uint32_t lhs_base, const Region& rhs, uint32_t rhs_base)const
+   {
+      EOS_TYPES_COMPARE_STATS_DEPTH();
+
+      for( uint32_t i = begin; i < end; )
+      {
+         const auto& s = steps[i];
+         uint32_t lhs_offset = lhs_base + s.offset;
+         uint32_t rhs_offset = rhs_base + s.offset;
+         int8_t c = 0;
+
+         switch( s.op )
+         {
+            case op_int8:
+               c = compare_primitives(lhs.template get<int8_t>(lhs_offset), rhs.template get<int8_t>(rhs_offset));
+               break;
+            case op_uint8:
+               c = compare_primitives(lhs.template get<uint8_t>(lhs_offset), rhs.template get<uint8_t>(rhs_offset));
+               break;
+            case op_int16:
+               c = compare_primitives(lhs.template get<int16_t>(lhs_offset), rhs.template get<int16_t>(rhs_offset));
+               break;
+            case op_uint16:
+               c = compare_primitives(lhs.template get<uint16_t>(lhs_offset), rhs.template get<uint16_t>(rhs_offset));
+               break;
+            case op_int32:
+               c = compare_primitives(lhs.template get<int32_t>(lhs_offset), rhs.template get<int32_t>(rhs_offset));
+               break;
+            case op_uint32:
+               c = compare_primitives(lhs.template get<uint32_t>(lhs_offset), rhs.template get<uint32_t>(rhs_offset));
+               break;
+            case op_int64:
+               c = compare_primitives(lhs.template get<int64_t>(lhs_offset), rhs.template get<int64_t>(rhs_offset));
+               break;
+            case op_uint64:
+               c = compare_primitives(lhs.template get<uint64_t>(lhs_offset), rhs.template get<uint64_t>(rhs_offset));
+               break;
+            case op_bool:
+               c = compare_primitives(lhs.template get<bool>(lhs_offset << 3), rhs.template get<bool>(rhs_offset << 3));
+               break;
+            case op_bytes:
+               c = compare_integer_runs_at(type_id::builtin_uint8, lhs, lhs_offset, rhs, rhs_offset);
+               break;
+            case op_rational:
+               c = compare_rationals(lhs.template get<int64_t>(lhs_offset), lhs.template get<uint64_t>(lhs_offset+8),
+                                     rhs.template get<int64_t>(rhs_offset), rhs.template get<uint64_t>(rhs_offset+8));
+               break;
+            case op_interpret:
+               c = tm.compare_data(type_id(s.arg), region_of(lhs), lhs_offset, region_of(rhs), rhs_offset);
+               break;
+            case op_array:
+            {
+               for( uint32_t j = 0; j < s.arg2; ++j, lhs_offset += s.arg, rhs_offset += s.arg )
+               {
+                  auto r = run(i + 1, s.next, lhs, lhs_offset, rhs, rhs_offset);
+                  if( r != 0 )
+                     return r; // Result of element program already accounts for direction.
+               }
+               break;
+            }
+            case op_vector:
+            {
+               auto element_type = get_integer_element_type(steps[i + 1], s.next == i + 2);
+               if( element_type != type_id::builtin_bool )
+               {
+                  c = compare_integer_runs_at(element_type, lhs, lhs_offset, rhs, rhs_offset);
+                  break;
+               }
+
+               auto lhs_num_elements = lhs.template get<uint32_t>(lhs_offset);
+               auto rhs_num_elements = rhs.template get<uint32_t>(rhs_offset);
+               auto num_elements = std::min(lhs_num_elements, rhs_num_elements);
+               uint32_t lhs_element_offset = lhs.template get<uint32_t>(lhs_offset+4);
+               uint32_t rhs_element_offset = rhs.template get<uint32_t>(rhs_offset+4);
+               for( uint32_t j = 0; j < num_elements; ++j, lhs_element_offset += s.arg, rhs_element_offset += s.arg )
+               {
+                  auto r = run(i + 1, s.next, lhs, lhs_element_offset, rhs, rhs_element_offset);
+                  if( r != 0 )
+                     return r;
+               }
+               c = compare_primitives(lhs_num_elements, rhs_num_elements);
+               break;
+            }
+            case op_optional:
+            {
+               bool lhs_exists = lhs.template get<bool>((lhs_offset + s.arg) << 3);
+               bool rhs_exists = rhs.template get<bool>((rhs_offset + s.arg) << 3);
+               if( lhs_exists && rhs_exists )
+               {
+                  auto r = run(i + 1, s.next, lhs, lhs_offset, rhs, rhs_offset);
+                  if( r != 0 )
+                     return r;
+               }
+               else
+                  c = compare_primitives(lhs_exists, rhs_exists);
+               break;
+            }
+            case op_variant:
+            {
+               auto lhs_which = lhs.template get<uint16_t>(lhs_offset + s.arg);
+               auto rhs_which = rhs.template get<uint16_t>(rhs_offset + s.arg);
+               if( lhs_which == rhs_which )
+               {
+                  if( lhs_which >= case_starts[s.arg2] )
+                     EOS_ERROR(std::out_of_range, "Case index specified by which is not valid");
+                  auto case_begin = case_starts[s.arg2 + 1 + lhs_which];
+                  auto case_end   = case_starts[s.arg2 + 2 + lhs_which];
+                  auto r = run(case_begin, case_end, lhs, lhs_offset, rhs, rhs_offset);
+                  if( r != 0 )
+                     return r;
+               }
+               else
+                  c = compare_primitives(lhs_which, rhs_which);
+               break;
+            }
+         }
+
+         if( c != 0 )
+            return (s.ascending ? c : -c);
+
+         i = s.next;
+      }
+
+      return 0;
+   }
+
+   inline void encode_byte_range(const raw_region& data, uint32_t offset, vector<byte>& out)
+   {
+      auto num_elements = data.get<uint32_t>(offset);
+      auto data_offset  = data.get<uint32_t>(offset+4);
+      if( static_cast<uint64_t>(data_offset) + num_elements > data.offset_end() )
+         EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
+
+      encode_bytes(data.get_raw_data().data() + data_offset, num_elements, out);
+   }
+
+   void compare_program::encode(uint32_t begin, uint32_t end, const raw_region& data, uint32_t base, vector<byte>& out)const
+   {
+      for( uint32_t i = begin; i < end; i = steps[i].next )
+      {
+         const auto& s = steps[i];
+         uint32_t offset = base + s.offset;
+         auto start = out.size();
+
+         switch( s.op )
+         {
+            case op_int8:
+               encode_integer(data.get<int8_t>(offset), out);
+               break;
+            case op_uint8:
+               encode_integer(data.get<uint8_t>(offset), out);
+               break;
+            case op_int16:
+               encode_integer(data.get<int16_t>(offset), out);
+               break;
+            case op_uint16:
+               encode_integer(data.get<uint16_t>(offset), out);
+               break;
+            case op_int32:
+               encode_integer(data.get<int32_t>(offset), out);
+               break;
+            case op_uint32:
+               encode_integer(data.get<uint32_t>(offset), out);
+               break;
+            case op_int64:
+               encode_integer(data.get<int64_t>(offset), out);
+               break;
+            case op_uint64:
+               encode_integer(data.get<uint64_t>(offset), out);
+               break;
+            case op_bool:
+               out.push_back( data.get<bool>(offset << 3) ? 1 : 0 );
+               break;
+            case op_bytes:
+               encode_byte_range(data, offset, out);
+               break;
+            case op_rational:
+               encode_rational(data.get<int64_t>(offset), data.get<uint64_t>(offset+8), out);
+               break;
+            case op_interpret:
+            {
+               type_id tid(s.arg);
+               if( tid.get_type_class() == type_id::builtin_type && tid.get_builtin_type() == type_id::builtin_any )
+               {
+                  auto any_type = data.get<uint32_t>(offset);
+                  encode_big_endian(any_type, out);
+                  if( any_type != 0 )
+                  {
+                     compare_program p(tm, type_id(any_type));
+                     p.encode(0, p.steps.size(), data, data.get<uint32_t>(offset+4), out);
+                  }
+               }
+               else
+               {
+                  compare_program p(tm, tid);
+                  p.encode(0, p.steps.size(), data, offset, out);
+               }
+               break;
+            }
+            case op_array:
+               for( uint32_t j = 0; j < s.arg2; ++j, offset += s.arg )
+                  encode(i + 1, s.next, data, offset, out); // Element program handles its own direction.
+               continue;
+            case op_vector:
+            {
+               auto num_elements   = data.get<uint32_t>(offset);
+               uint32_t element_offset = data.get<uint32_t>(offset+4);
+               for( uint32_t j = 0; j < num_elements; ++j, element_offset += s.arg )
+               {
+                  out.push_back( s.ascending ? 1 : 0xFE );
+                  encode(i + 1, s.next, data, element_offset, out);
+               }
+               out.push_back( s.ascending ? 0 : 0xFF );
+               continue;
+            }
+            case op_optional:
+               if( data.get<bool>((offset + s.arg) << 3) )
+               {
+                  out.push_back( s.ascending ? 1 : 0xFE );
+                  encode(i + 1, s.next, data, offset, out);
+               }
+               else
+                  out.push_back( s.ascending ? 0 : 0xFF );
+               continue;
+            case op_variant:
+            {
+               auto which = data.get<uint16_t>(offset + s.arg);
+               if( which >= case_starts[s.arg2] )
+                  EOS_ERROR(std::out_of_range, "Case index specified by which is not valid");
+               encode_big_endian( static_cast<uint16_t>( s.ascending ? which : ~which ), out );
+               encode(case_starts[s.arg2 + 1 + which], case_starts[s.arg2 + 2 + which], data, offset, out);
+               continue;
+            }
+         }
+
+         if( !s.ascending )
+            invert_bytes(out, start);
+      }
+   }
+
+   void compare_program::normalize(const raw_region& data, vector<byte>& out, uint16_t num_members)const
+   {
+      uint32_t end = steps.size();
+      if( num_members < member_ends.size() )
+         end = (num_members == 0 ? 0 : member_ends[num_members - 1]);
+      encode(0, end, data, 0, out);
+   }
+
+   bool compare_program::get_fixed_size(uint32_t begin, uint32_t end, uint32_t& size)const
+   {
+      for( uint32_t i = begin; i < end; i = steps[i].next )
+      {
+         const auto& s = steps[i];
+         switch( s.op )
+         {
+            case op_int8:
+            case op_uint8:
+            case op_bool:
+               size += 1;
+               break;
+            case op_int16:
+            case op_uint16:
+               size += 2;
+               break;
+            case op_int32:
+            case op_uint32:
+               size += 4;
+               break;
+            case op_int64:
+            case op_uint64:
+               size += 8;
+               break;
+            case op_array:
+            {
+               uint32_t element_size = 0;
+               if( !get_fixed_size(i + 1, s.next, element_size) )
+                  return false;
+               size += element_size * s.arg2;
+               break;
+            }
+            default:
+               return false;
+         }
+      }
+      return true;
+   }
+
+   uint32_t compare_program::get_normalized_size()const
+   {
+      uint32_t size = 0;
+      if( !get_fixed_size(0, steps.size(), size) )
+         return 0;
+      return size;
+   }
+
+   int8_t compare_program::compare_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs)const
+   {
+      auto c = run(0, steps.size(), lhs, 0, rhs, 0);
+      if( c == 0 && !unique )
+         c = compare_primitives(lhs_id, rhs_id);
+      return c;
+   }
+
+   int8_t compare_program::compare_validated_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs)const
+   {
+      auto c = run(0, steps.size(), trusted_region(lhs), 0, trusted_region(rhs), 0);
+      if( c == 0 && !unique )
+         c = compare_primitives(lhs_id, rhs_id);
+      return c;
+   }
+
+   template<typename Region>
+   int8_t compare_program::run_with_key(const Region& object, const Region& key, const vector<uint32_t>& key_bases, uint32_t end)const
+   {
+      // The key base of a top-level step is the difference between its offsets in the key and in the object (in 32-bit arithmetic, like
+      // the offsets in run), so running the step from that base reads the key where the key_view program would.
+      for( uint32_t i = 0; i < end; i = steps[i].next )
+      {
+         auto c = run(i, steps[i].next, object, 0, key, key_bases[i]);
+         if( c != 0 )
+            return c;
+      }
+      return 0;
+   }
+
+   int8_t compare_program::compare_object_with_key(const raw_region& object, const raw_region& key, const vector<uint32_t>& key_bases, uint32_t end)const
+   {
+      return run_with_key(object, key, key_bases, end);
+   }
+
+   int8_t compare_program::compare_validated_object_with_key(const raw_region& object, const raw_region& key, const vector<uint32_t>& key_bases,
+                                                             uint32_t end)const
+   {
+      return run_with_key(trusted_region(object), trusted_region(key), key_bases, end);
+   }
+
+   vector<uint32_t> compare_program::get_key_bases(const compare_program& key_program)const
+   {
+      if( steps.size() != key_program.steps.size() || member_ends != key_program.member_ends || case_starts != key_program.case_starts )
+         EOS_ERROR(std::runtime_error, "Invariant failure: key and key-shaped view into the object are compared differently.");
+
+      vector<uint32_t> key_bases(steps.size(), 0);
+      uint32_t next_top_level = 0;
+      for( uint32_t i = 0; i < steps.size(); ++i )
+      {
+         const auto& s = steps[i];
+         const auto& k = key_program.steps[i];
+         bool top_level = (i == next_top_level);
+         if( s.op != k.op || s.ascending != k.ascending || s.arg != k.arg || s.arg2 != k.arg2 || s.next != k.next
+             || (!top_level && s.offset != k.offset) )
+            EOS_ERROR(std::runtime_error, "Invariant failure: key and key-shaped view into the object are compared differently.");
+
+         if( top_level )
+         {
+            key_bases[i] = k.offset - s.offset;
+            next_top_level = s.next;
+         }
+      }
+      return key_bases;
+   }
+
+   bool compare_program::validate(const raw_region& data, uint16_t num_members)const
+   {
+      return validate(0, get_members_end(num_members), data, 0);
+   }
+
+   bool compare_program::validate(uint32_t begin, uint32_t end, const raw_region& data, uint32_t base)const
+   {
+      // Offsets are computed with the same (32-bit) arithmetic as in run, so that exactly the locations run reads are checked.
+      auto in_bounds      = [&](uint64_t offset, uint64_t size) { return offset + size <= data.offset_end(); };
+      auto bool_in_bounds = [&](uint32_t offset_in_bits)        { return in_bounds(offset_in_bits >> 3, 1); };
+
+      for( uint32_t i = begin; i < end; )
+      {
+         const auto& s = steps[i];
+         uint32_t offset = base + s.offset;
+
+         switch( s.op )
+         {
+            case op_int8:
+            case op_uint8:
+               if( !in_bounds(offset, 1) )
+                  return false;
+               break;
+            case op_bool:
+               if( !bool_in_bounds(offset << 3) )
+                  return false;
+               break;
+            case op_int16:
+            case op_uint16:
+               if( !in_bounds(offset, 2) )
+                  return false;
+               break;
+            case op_int32:
+            case op_uint32:
+               if( !in_bounds(offset, 4) )
+                  return false;
+               break;
+            case op_int64:
+            case op_uint64:
+               if( !in_bounds(offset, 8) )
+                  return false;
+               break;
+            case op_rational:
+               if( !in_bounds(offset, 16) )
+                  return false;
+               break;
+            case op_bytes:
+            {
+               if( !in_bounds(offset, 8) )
+                  return false;
+               auto num_elements = data.get<uint32_t>(offset);
+               auto data_offset  = data.get<uint32_t>(offset+4);
+               if( !in_bounds(data_offset, num_elements) )
+                  return false;
+               break;
+            }
+            case op_interpret: // types_manager_common::compare_data checks its own reads.
+               break;
+            case op_array:
+            {
+               for( uint32_t j = 0; j < s.arg2; ++j, offset += s.arg )
+               {
+                  if( !validate(i + 1, s.next, data, offset) )
+                     return false;
+               }
+               break;
+            }
+            case op_vector:
+            {
+               if( !in_bounds(offset, 8) )
+                  return false;
+               auto num_elements = data.get<uint32_t>(offset);
+               uint32_t element_offset = data.get<uint32_t>(offset+4);
+               if( num_elements > 0 && (element_offset % s.arg2 != 0 || !in_bounds(element_offset, static_cast<uint64_t>(num_elements) * s.arg)) )
+                  return false;
+               for( uint32_t j = 0; j < num_elements; ++j, element_offset += s.arg )
+               {
+                  if( !validate(i + 1, s.next, data, element_offset) )
+                     return false;
+               }
+               break;
+            }
+            case op_optional:
+            {
+               if( !bool_in_bounds((offset + s.arg) << 3) )
+                  return false;
+               if( data.get<bool>((offset + s.arg) << 3) && !validate(i + 1, s.next, data, offset) )
+                  return false;
+               break;
+            }
+            case op_variant:
+            {
+               if( !in_bounds(static_cast<uint32_t>(offset + s.arg), 2) )
+                  return false;
+               auto which = data.get<uint16_t>(offset + s.arg);
+               if( which >= case_starts[s.arg2] )
+                  return false;
+               if( !validate(case_starts[s.arg2 + 1 + which], case_starts[s.arg2 + 2 + which], data, offset) )
+                  return false;
+               break;
+            }
+         }
+
+         i = s.next;
+      }
+
+      return true;
+   }
+
+} }
@@ -0,0 +1,144 @@
+#include <eos/eoslib/compare_stats.hpp>
+
+#ifdef EOS_TYPES_COMPARE_STATS
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+
+namespace eos { namespace types {
+
+   thread_local compare_trace* current_compare_trace = nullptr;
+
+   namespace {
+
+      using stats_key = std::tuple<const types_manager_common*, type_id::index_t, uint8_t>;
+
+      struct stats_registry
+      {
+         std::mutex                                          mutex;
+         std::map<stats_key, std::unique_ptr<compare_stats>> stats;
+      };
+
+      stats_registry& get_registry()
+      {
+         static stats_registry registry;
+         return registry;
+      }
+
+      uint32_t latency_bucket(uint64_t ns)
+      {
+         uint32_t bucket = 0;
+         while( ns > 0 && bucket + 1 < compare_stats::num_latency_buckets )
+         {
+            ns >>= 1;
+            ++bucket;
+         }
+         return bucket;
+      }
+
+   }
+
+   void compare_stats::reset()
+   {
+      object_comparisons = 0;
+      key_comparisons    = 0;
+      total_depth        = 0;
+      max_depth          = 0;
+      bytes_touched      = 0;
+      total_ns           = 0;
+      for( auto& b : latency_histogram )
+         b = 0;
+   }
+
+   compare_stats& get_compare_stats(const types_manager_common& tm, type_id::index_t table, uint8_t index_seq_num)
+   {
+      auto& registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      auto& s = registry.stats[stats_key(&tm, table, index_seq_num)];
+      if( !s )
+         s.reset(new compare_stats());
+      return *s;
+   }
+
+   std::vector<compare_stats_entry> get_all_compare_stats()
+   {
+      auto& registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      std::vector<compare_stats_entry> entries;
+      for( const auto& p : registry.stats )
+         entries.push_back(compare_stats_entry{std::get<0>(p.first), std::get<1>(p.first), std::get<2>(p.first), p.second.get()});
+      return entries;
+   }
+
+   void reset_compare_stats()
+   {
+      auto& registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for( auto& p : registry.stats )
+         p.second->reset();
+   }
+
+   void print_compare_stats(std::ostream& os)
+   {
+      for( const auto& e : get_all_compare_stats() )
+      {
+         const auto& s = *e.stats;
+         uint64_t n = s.object_comparisons + s.key_comparisons;
+         if( n == 0 )
+            continue;
+
+         os << "table " << e.table << " index " << static_cast<uint32_t>(e.index_seq_num) << ": "
+            << s.object_comparisons << " object comparisons, " << s.key_comparisons << " key comparisons, "
+            << "depth " << std::fixed << std::setprecision(2) << static_cast<double>(s.total_depth) / n << " avg / " << s.max_depth << " max, "
+            << std::setprecision(1) << static_cast<double>(s.bytes_touched) / n << " bytes avg, "
+            << static_cast<double>(s.total_ns) / n << " ns avg" << std::endl;
+
+         os << "   ns <";
+         uint32_t last = 0;
+         for( uint32_t i = 0; i < compare_stats::num_latency_buckets; ++i )
+            if( s.latency_histogram[i] > 0 )
+               last = i;
+         for( uint32_t i = 0; i <= last; ++i )
+            os << ' ' << (uint64_t(1) << i) << ':' << s.latency_histogram[i];
+         os << std::endl;
+      }
+   }
+
+   compare_stats_scope::compare_stats_scope(compare_stats& stats, bool key_comparison)
+      : stats(nullptr), key_comparison(key_comparison)
+   {
+      if( current_compare_trace != nullptr )
+         return;
+      this->stats = &stats;
+      current_compare_trace = &trace;
+      start = std::chrono::steady_clock::now();
+   }
+
+   compare_stats_scope::~compare_stats_scope()
+   {
+      if( stats == nullptr )
+         return;
+
+      auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      current_compare_trace = nullptr;
+
+      auto relaxed = std::memory_order_relaxed;
+      (key_comparison ? stats->key_comparisons : stats->object_comparisons).fetch_add(1, relaxed);
+      stats->total_depth.fetch_add(trace.max_depth, relaxed);
+      stats->bytes_touched.fetch_add(trace.bytes, relaxed);
+      stats->total_ns.fetch_add(ns, relaxed);
+      stats->latency_histogram[latency_bucket(ns)].fetch_add(1, relaxed);
+
+      uint64_t max_depth = stats->max_depth.load(relaxed);
+      while( trace.max_depth > max_depth && !stats->max_depth.compare_exchange_weak(max_depth, trace.max_depth, relaxed) )
+         ;
+   }
+
+} }
+
+#endif
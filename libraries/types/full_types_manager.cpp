@@ -244,6 +244,29 @@ namespace eos { namespace types {
          return valid_indices.end();
    }
 
+   full_types_manager::memory_breakdown full_types_manager::get_memory_usage()const
+   {
+      memory_breakdown b;
+      b.types          = memory_usage_of(types);
+      b.members        = memory_usage_of(members);
+      b.lookup_by_name = memory_usage_of(lookup_by_name);
+      b.valid_indices  = memory_usage_of(valid_indices);
+      b.field_names    = memory_usage_of(field_names);
+      b.fields_info    = memory_usage_of(fields_info);
+      return b;
+   }
+
+   memory_usage full_types_manager::memory_breakdown::get_total()const
+   {
+      auto total = types;
+      total += members;
+      total += lookup_by_name;
+      total += valid_indices;
+      total += field_names;
+      total += fields_info;
+      return total;
+   }
+
 #ifdef EOS_TYPES_FULL_CAPABILITY
    
    struct print_type_visitor
@@ -474,7 +497,23 @@ namespace eos { namespace types {
       traverse_type(tid, v);
    }
 
+   void full_types_manager::memory_breakdown::print(std::ostream& os)const
+   {
+      auto line = [&](const char* name, const memory_usage& u)
+      {
+         os << "   " << name << ": " << u.used << " bytes used, " << u.reserved << " reserved" << std::endl;
+      };
+
+      auto total = get_total();
+      os << "full_types_manager: " << total.used << " bytes used, " << total.reserved << " reserved" << std::endl;
+      line("types", types);
+      line("members", members);
+      line("lookup_by_name", lookup_by_name);
+      line("valid_indices", valid_indices);
+      line("field_names", field_names);
+      line("fields_info", fields_info);
+   }
+
 #endif
 
 } }
-
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <eos/eoslib/types_manager_common.hpp>
+#include <eos/eoslib/exceptions.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace eos { namespace types {
+
+   // Kernels comparing contiguous runs of bytes or of builtin integers, as stored in strings, bytes and vectors.
+   // The vectorized paths are chosen at compile time: AVX2 if enabled (e.g. with -mavx2), otherwise SSE2 (always available on x86-64),
+   // otherwise 8 bytes at a time through 64-bit words.
+
+   // Returns the position of the first byte at which l and r differ, or n if the first n bytes are equal.
+   inline uint32_t first_mismatch(const byte* l, const byte* r, uint32_t n)
+   {
+      uint32_t i = 0;
+#if defined(__AVX2__)
+      for( ; i + 32 <= n; i += 32 )
+      {
+         auto eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(l + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i)));
+         uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+         if( mask != 0xFFFFFFFFu )
+            return i + __builtin_ctz(~mask);
+      }
+#endif
+#if defined(__SSE2__)
+      for( ; i + 16 <= n; i += 16 )
+      {
+         auto eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i)));
+         uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+         if( mask != 0xFFFFu )
+            return i + __builtin_ctz(~mask & 0xFFFFu);
+      }
+#endif
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      for( ; i + 8 <= n; i += 8 )
+      {
+         uint64_t a, b;
+         std::memcpy(&a, l + i, sizeof(a));
+         std::memcpy(&b, r + i, sizeof(b));
+         if( a != b )
+            return i + (__builtin_ctzll(a ^ b) >> 3);
+      }
+#endif
+      for( ; i < n; ++i )
+      {
+         if( l[i] != r[i] )
+            return i;
+      }
+      return n;
+   }
+
+   // Lexicographic comparison of runs of num_lhs and num_rhs elements of the builtin integer type T (bytes for strings),
+   // where a run that is a prefix of the other sorts first.
+   template<typename T>
+   inline
+   typename std::enable_if<std::is_integral<T>::value, int8_t>::type
+   compare_integer_runs(const byte* lhs, uint32_t num_lhs, const byte* rhs, uint32_t num_rhs)
+   {
+      uint32_t n = (num_lhs < num_rhs ? num_lhs : num_rhs);
+      uint64_t num_bytes = static_cast<uint64_t>(n) * sizeof(T);
+      uint64_t pos = 0;
+      while( pos < num_bytes ) // Chunks of at most 2^31 bytes so that positions fit in first_mismatch
+      {
+         uint32_t chunk = static_cast<uint32_t>(std::min<uint64_t>(num_bytes - pos, uint64_t(1) << 31));
+         uint32_t m = first_mismatch(lhs + pos, rhs + pos, chunk);
+         if( m < chunk )
+         {
+            // The first differing byte lies in the first differing element, which decides the order.
+            uint64_t element_start = (pos + m) - (pos + m) % sizeof(T);
+            EOS_TYPES_COMPARE_STATS_TOUCH(2 * (element_start + sizeof(T)));
+            T a, b;
+            std::memcpy(&a, lhs + element_start, sizeof(T));
+            std::memcpy(&b, rhs + element_start, sizeof(T));
+            return compare_primitives(a, b);
+         }
+         pos += chunk;
+      }
+      EOS_TYPES_COMPARE_STATS_TOUCH(2 * num_bytes);
+      return compare_primitives(num_lhs, num_rhs);
+   }
+
+   // Size of the builtin integer type b, or 0 if b is not an integer type.
+   inline uint32_t get_builtin_integer_size(type_id::builtin b)
+   {
+      switch( b )
+      {
+         case type_id::builtin_int8:
+         case type_id::builtin_uint8:
+            return 1;
+         case type_id::builtin_int16:
+         case type_id::builtin_uint16:
+            return 2;
+         case type_id::builtin_int32:
+         case type_id::builtin_uint32:
+            return 4;
+         case type_id::builtin_int64:
+         case type_id::builtin_uint64:
+            return 8;
+         default:
+            return 0;
+      }
+   }
+
+   // compare_integer_runs for the builtin integer type b (see get_builtin_integer_size).
+   inline int8_t compare_builtin_integer_runs(type_id::builtin b, const byte* lhs, uint32_t num_lhs, const byte* rhs, uint32_t num_rhs)
+   {
+      switch( b )
+      {
+         case type_id::builtin_int8:   return compare_integer_runs<int8_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_uint8:  return compare_integer_runs<uint8_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_int16:  return compare_integer_runs<int16_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_uint16: return compare_integer_runs<uint16_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_int32:  return compare_integer_runs<int32_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_uint32: return compare_integer_runs<uint32_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_int64:  return compare_integer_runs<int64_t>(lhs, num_lhs, rhs, num_rhs);
+         case type_id::builtin_uint64: return compare_integer_runs<uint64_t>(lhs, num_lhs, rhs, num_rhs);
+         default:
+            EOS_ERROR(std::invalid_argument, "Not a builtin integer type");
+      }
+      return 0;
+   }
+
+} }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <eos/eoslib/types_manager_common.hpp>
+#include <eos/eoslib/raw_region.hpp>
+
+#include <vector>
+
+namespace eos { namespace types {
+
+   using std::vector;
+
+   // A table_index compiled into a flat sequence of comparison steps.
+   // Produces the same ordering as types_manager_common::compare_objects, but without walking the type metadata on every call.
+   // The same steps can also emit a normalized (memcomparable) encoding of the key: comparing two encodings with memcmp
+   // gives the same order as comparing the original data with the program.
+   class compare_program
+   {
+   public:
+
+      enum view : uint8_t
+      {
+         object_view = 0, // Steps address the key-shaped view into the table object (see table_index::get_sorted_members).
+         key_view         // Steps address an instance of the key type of the index.
+      };
+
+      enum opcode : uint8_t
+      {
+         op_int8 = 0,
+         op_uint8,
+         op_int16,
+         op_uint16,
+         op_int32,
+         op_uint32,
+         op_int64,
+         op_uint64,
+         op_bool,
+         op_bytes,     // String or Bytes
+         op_rational,
+         op_array,     // Element program follows the step; arg = stride, arg2 = number of elements
+         op_vector,    // Element program follows the step; arg = stride, arg2 = alignment of the elements
+         op_optional,  // Element program follows the step; arg = tag offset
+         op_variant,   // Case programs follow the step; arg = tag offset, arg2 = index into case_starts of the first case
+         op_interpret  // Falls back to types_manager_common::compare_data; arg = storage of the type_id
+      };
+
+      struct step
+      {
+         uint32_t offset;    // Relative to the start of the enclosing object, element, or variant case.
+         opcode   op;
+         bool     ascending; // Absolute direction, i.e. after folding in the directions of the index and all enclosing structs.
+         uint32_t arg;
+         uint32_t arg2;
+         uint32_t next;      // Index of the next sibling step. Steps in between (if any) form the program of the contained type(s).
+      };
+
+      explicit compare_program(const types_manager_common::table_index& ti, view v = object_view);
+
+      int8_t compare_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs)const;
+
+      // Same as compare_objects but without any bounds checks, so lhs and rhs must have passed validate.
+      int8_t compare_validated_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs)const;
+
+      // Checks once that every read the program makes from data is within bounds (including the contents of strings and vectors,
+      // whose offsets and lengths are stored in the data) and that the elements of vectors are aligned.
+      // If num_members is given, only the reads for the first num_members sorted members of the key are checked.
+      bool   validate(const raw_region& data, uint16_t num_members = std::numeric_limits<uint16_t>::max())const;
+
+      // For an object_view program, the offsets to add to its top-level steps to address the same members in data laid out as key_program,
+      // the key_view program of the same index (indexed like steps; only the entries of top-level steps are meaningful).
+      // Throws if the two programs compare differently in any other way.
+      vector<uint32_t> get_key_bases(const compare_program& key_program)const;
+
+      // Compares object data with key data, given the key bases of get_key_bases, using only the steps before end (see get_members_end).
+      int8_t compare_object_with_key(const raw_region& object, const raw_region& key, const vector<uint32_t>& key_bases, uint32_t end)const;
+
+      // Same as compare_object_with_key but without any bounds checks, so object must have passed validate, and key must have passed
+      // validate of the key_view program for the members compared.
+      int8_t compare_validated_object_with_key(const raw_region& object, const raw_region& key, const vector<uint32_t>& key_bases, uint32_t end)const;
+
+      // Appends the normalized encoding of the key in data to out. Does not include the id tie-breaker of non-unique indices.
+      // If num_members is given, only the first num_members sorted members of the key are encoded, which yields a prefix of the full encoding.
+      void   normalize(const raw_region& data, vector<byte>& out, uint16_t num_members = std::numeric_limits<uint16_t>::max())const;
+
+      // Size of the normalized encoding if it is the same for all data (i.e. the key only contains integers, bools and arrays of them); otherwise 0.
+      uint32_t get_normalized_size()const;
+
+      inline const vector<step>& get_steps()const { return steps; }
+      inline bool                is_unique()const { return unique; }
+      inline uint16_t            get_num_members()const { return static_cast<uint16_t>(member_ends.size()); }
+
+      // Index into steps following the programs of the first num_members sorted members of the key.
+      inline uint32_t get_members_end(uint16_t num_members)const
+      {
+         if( num_members == 0 )
+            return 0;
+         return ( num_members < member_ends.size() ? member_ends[num_members - 1] : static_cast<uint32_t>(steps.size()) );
+      }
+
+   private:
+
+      const types_manager_common& tm;
+      vector<step>                steps;
+      vector<uint32_t>            case_starts; // For each variant: the number of cases, then the start index (into steps) of each case program, then the end of the last case.
+      vector<uint32_t>            member_ends; // For each sorted member of the key: the index (into steps) following its program
+      bool                        unique;
+
+      compare_program(const types_manager_common& tm, type_id tid); // Program for a single type in ascending order
+
+      void   compile_type(type_id tid, uint32_t offset, bool ascending, vector<type_id::index_t>& struct_stack);
+      void   add_step(opcode op, uint32_t offset, bool ascending, uint32_t arg = 0, uint32_t arg2 = 0);
+      template<typename Region>
+      int8_t run(uint32_t begin, uint32_t end, const Region& lhs, uint32_t lhs_base, const Region& rhs, uint32_t rhs_base)const;
+      template<typename Region>
+      int8_t run_with_key(const Region& object, const Region& key, const vector<uint32_t>& key_bases, uint32_t end)const;
+      bool   validate(uint32_t begin, uint32_t end, const raw_region& data, uint32_t base)const;
+      void   encode(uint32_t begin, uint32_t end, const raw_region& data, uint32_t base, vector<byte>& out)const;
+      bool   get_fixed_size(uint32_t begin, uint32_t end, uint32_t& size)const;
+   };
+
+} }
+
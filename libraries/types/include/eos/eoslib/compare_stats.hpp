@@ -0,0 +1,152 @@
+#pragma once
+
+// Instrumentation of the comparisons made for table indices. Only compiled in when EOS_TYPES_COMPARE_STATS is defined
+// (e.g. configure with -DEOS_TYPES_COMPARE_STATS=ON); otherwise the macros at the end expand to nothing.
+
+#ifdef EOS_TYPES_COMPARE_STATS
+
+#ifndef EOS_TYPES_FULL_CAPABILITY
+#error "EOS_TYPES_COMPARE_STATS requires EOS_TYPES_FULL_CAPABILITY"
+#endif
+
+#include <eos/eoslib/type_id.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+
+namespace eos { namespace types {
+
+   class types_manager_common;
+
+   // Counters of the comparisons made for one index. Updated concurrently by any number of threads.
+   struct compare_stats
+   {
+      static const uint32_t num_latency_buckets = 32; // Bucket i counts the comparisons that took less than 2^i ns (and at least 2^(i-1) ns)
+
+      std::atomic<uint64_t> object_comparisons; // Comparisons of two objects
+      std::atomic<uint64_t> key_comparisons;    // Comparisons of an object with a lookup key
+      std::atomic<uint64_t> total_depth;        // Sum over all comparisons of the deepest nesting of types (or compare_program steps) reached
+      std::atomic<uint64_t> max_depth;
+      std::atomic<uint64_t> bytes_touched;      // Bytes read from both sides of all comparisons
+      std::atomic<uint64_t> total_ns;
+      std::array<std::atomic<uint64_t>, num_latency_buckets> latency_histogram;
+
+      compare_stats() { reset(); }
+
+      void reset();
+   };
+
+   struct compare_stats_entry
+   {
+      const types_manager_common* tm;
+      type_id::index_t            table;
+      uint8_t                     index_seq_num;
+      const compare_stats*        stats;
+   };
+
+   // Stats of the index index_seq_num of the table at index table of tm. Created on first use and kept (at the same address) until exit.
+   compare_stats&                   get_compare_stats(const types_manager_common& tm, type_id::index_t table, uint8_t index_seq_num);
+
+   std::vector<compare_stats_entry> get_all_compare_stats();
+   void                             reset_compare_stats();
+   void                             print_compare_stats(std::ostream& os);
+
+   // What the comparison being measured on the current thread has done so far.
+   struct compare_trace
+   {
+      uint32_t depth     = 0;
+      uint32_t max_depth = 0;
+      uint64_t bytes     = 0;
+   };
+
+   extern thread_local compare_trace* current_compare_trace;
+
+   // Measures the comparison made during its lifetime into stats. Does nothing if a comparison is already being measured on this thread
+   // (e.g. when an instrumented comparator calls another), so that each comparison is counted once.
+   class compare_stats_scope
+   {
+   public:
+
+      compare_stats_scope(compare_stats& stats, bool key_comparison);
+      ~compare_stats_scope();
+
+      compare_stats_scope(const compare_stats_scope&) = delete;
+      compare_stats_scope& operator=(const compare_stats_scope&) = delete;
+
+   private:
+      compare_stats*                        stats;
+      bool                                  key_comparison;
+      compare_trace                         trace;
+      std::chrono::steady_clock::time_point start;
+   };
+
+   class compare_depth_guard
+   {
+   public:
+
+      inline compare_depth_guard()
+      {
+         if( auto t = current_compare_trace )
+         {
+            if( ++t->depth > t->max_depth )
+               t->max_depth = t->depth;
+         }
+      }
+
+      inline ~compare_depth_guard()
+      {
+         if( auto t = current_compare_trace )
+            --t->depth;
+      }
+   };
+
+   inline void touch_compared_bytes(uint64_t num_bytes)
+   {
+      if( auto t = current_compare_trace )
+         t->bytes += num_bytes;
+   }
+
+   // Stats of an index looked up once, for comparators that are constructed from a table_index.
+   class compare_stats_ref
+   {
+   public:
+
+      template<typename TableIndex>
+      explicit compare_stats_ref(const TableIndex& ti)
+         : stats(&get_compare_stats(ti.get_types_manager(), ti.get_table(), ti.get_index_seq_num()))
+      {}
+
+      inline compare_stats& get()const { return *stats; }
+
+   private:
+      compare_stats* stats;
+   };
+
+} }
+
+#define EOS_TYPES_COMPARE_STATS_SCOPE(stats, key_comparison) eos::types::compare_stats_scope _compare_stats_scope(stats, key_comparison)
+#define EOS_TYPES_COMPARE_STATS_DEPTH()                      eos::types::compare_depth_guard _compare_depth_guard
+#define EOS_TYPES_COMPARE_STATS_TOUCH(num_bytes)             eos::types::touch_compared_bytes(num_bytes)
+
+#else
+
+namespace eos { namespace types {
+
+   class compare_stats_ref
+   {
+   public:
+
+      template<typename TableIndex>
+      explicit compare_stats_ref(const TableIndex&) {}
+   };
+
+} }
+
+#define EOS_TYPES_COMPARE_STATS_SCOPE(stats, key_comparison)
+#define EOS_TYPES_COMPARE_STATS_DEPTH()
+#define EOS_TYPES_COMPARE_STATS_TOUCH(num_bytes)
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <eos/eoslib/types_manager_common.hpp>
 #include <eos/eoslib/bit_view.hpp>
+#include <eos/eoslib/memory_usage.hpp>
 
 #include <string>
 #include <boost/container/flat_map.hpp>
@@ -43,6 +44,22 @@ namespace eos { namespace types {
          sum_type_index,
       };
 
+      // Memory held by each container of a full_types_manager (see memory_usage).
+      struct memory_breakdown
+      {
+         memory_usage types;
+         memory_usage members;
+         memory_usage lookup_by_name;
+         memory_usage valid_indices;
+         memory_usage field_names;
+         memory_usage fields_info;
+
+         memory_usage get_total()const;
+#ifdef EOS_TYPES_FULL_CAPABILITY
+         void         print(std::ostream& os)const;
+#endif
+      };
+
       full_types_manager(const full_types_manager& other)
          : types_manager_common(types, members), 
            types(other.types), members(other.members), 
@@ -69,6 +86,8 @@ namespace eos { namespace types {
       bool                                               is_type_valid(type_id tid)const;
       type_id::size_align                                get_size_align(type_id tid)const;
 
+      memory_breakdown                                   get_memory_usage()const;
+
 
       friend class types_constructor;
 
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <eos/eoslib/raw_region.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace eos { namespace types {
+
+   using std::vector;
+
+   // Encodings of builtin values into normalized keys (see compare_program::normalize), whose memcmp order is the order of the values.
+   // A descending value is encoded as the ascending encoding with every byte inverted (see invert_bytes).
+
+   template<typename T>
+   inline void encode_big_endian(T v, vector<byte>& out)
+   {
+      for( int shift = 8*(sizeof(T)-1); shift >= 0; shift -= 8 )
+         out.push_back(static_cast<byte>(v >> shift));
+   }
+
+   template<typename T>
+   inline void encode_integer(T v, vector<byte>& out)
+   {
+      using U = typename std::make_unsigned<T>::type;
+      U u = static_cast<U>(v);
+      if( std::is_signed<T>::value )
+         u ^= (static_cast<U>(1) << (8*sizeof(T) - 1)); // Flip the sign bit so negative numbers sort first.
+      encode_big_endian(u, out);
+   }
+
+   inline void encode_bytes(const byte* d, uint32_t num_bytes, vector<byte>& out)
+   {
+      for( uint32_t i = 0; i < num_bytes; ++i )
+      {
+         out.push_back(d[i]);
+         if( d[i] == 0 )
+            out.push_back(0xFF); // Escape zero bytes so that the 0x00 0x00 terminator sorts before any continuation.
+      }
+      out.push_back(0);
+      out.push_back(0);
+   }
+
+   // Rationals are encoded by class (negative infinity, finite, positive infinity), then for finite values by the floor of the value 
+   // followed by the continued fraction expansion of the remaining fraction. Expansion terms at odd positions are inverted since a larger
+   // term there makes the value smaller. The terminator stands for an infinite term at that position, which is why it sorts below the 
+   // term markers at odd positions and above them at even positions. 
+   // Denominators of zero are ordered by their numerators, as in compare_rationals. 0/0 (which compares equal to everything) is encoded as zero.
+   inline void encode_rational(int64_t numerator, uint64_t denominator, vector<byte>& out)
+   {
+      if( denominator == 0 && numerator != 0 )
+      {
+         out.push_back( numerator < 0 ? 0 : 2 );
+         encode_integer(numerator, out);
+         return;
+      }
+      out.push_back(1);
+      if( denominator == 0 )
+         denominator = 1;
+
+      __int128 floor_value = static_cast<__int128>(numerator) / denominator;
+      __int128 remainder   = static_cast<__int128>(numerator) - floor_value * denominator;
+      if( remainder < 0 )
+      {
+         --floor_value;
+         remainder += denominator;
+      }
+      encode_integer(static_cast<int64_t>(floor_value), out);
+
+      uint64_t a = denominator;
+      uint64_t b = static_cast<uint64_t>(remainder);
+      bool odd_position = true;
+      for( ; b != 0; odd_position = !odd_position )
+      {
+         uint64_t term = a / b;
+         out.push_back(1);
+         encode_big_endian( (odd_position ? ~term : term), out );
+         uint64_t r = a % b;
+         a = b;
+         b = r;
+      }
+      out.push_back( odd_position ? 0 : 2 );
+   }
+
+   inline void invert_bytes(vector<byte>& out, size_t start)
+   {
+      for( auto i = start; i < out.size(); ++i )
+         out[i] = ~out[i];
+   }
+
+} }
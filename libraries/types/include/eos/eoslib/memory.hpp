@@ -343,6 +343,37 @@ namespace eoslib {
                                                            true_type>::value>
    {};
 
+   template <class _Alloc>
+   auto __has_select_on_container_copy_construction_test(_Alloc&& __a) -> decltype(__a.select_on_container_copy_construction(), true_type());
+
+   template <class _Alloc>
+   auto __has_select_on_container_copy_construction_test(const volatile _Alloc& __a) -> false_type;
+
+   template <class _Alloc>
+   struct __has_select_on_container_copy_construction 
+      : integral_constant<bool, is_same<decltype(__has_select_on_container_copy_construction_test(declval<_Alloc&>())),
+                                        true_type>::value>
+   {};
+
+   template <class _Tp, class = void> struct __has_propagate_on_container_move_assignment : false_type {};
+
+   template <class _Tp> 
+   struct __has_propagate_on_container_move_assignment<_Tp, typename __void_t<typename _Tp::propagate_on_container_move_assignment>::type> 
+      : true_type 
+   {};
+
+   template <class _Alloc, bool = __has_propagate_on_container_move_assignment<_Alloc>::value>
+   struct __propagate_on_container_move_assignment
+   {
+      typedef false_type type;
+   };
+
+   template <class _Alloc>
+   struct __propagate_on_container_move_assignment<_Alloc, true>
+   {
+      typedef typename _Alloc::propagate_on_container_move_assignment type;
+   };
+
    template <class _Alloc, class _Ptr, bool = __has_difference_type<_Alloc>::value>
    struct __alloc_traits_difference_type
    {
@@ -372,6 +403,8 @@ namespace eoslib {
       template <class _Tp> using rebind_alloc  = typename __allocator_traits_rebind<allocator_type, _Tp>::type;
       template <class _Tp> using rebind_traits = allocator_traits<rebind_alloc<_Tp>>;
 
+      using propagate_on_container_move_assignment = typename __propagate_on_container_move_assignment<allocator_type>::type;
+
       static pointer allocate(allocator_type& __a, size_type __n) 
       { 
          return __a.allocate(__n); 
@@ -404,6 +437,11 @@ namespace eoslib {
          return __max_size(__has_max_size<const allocator_type>(), __a);
       }
 
+      static allocator_type select_on_container_copy_construction(const allocator_type& __a)
+      {
+         return __select_on_container_copy_construction(__has_select_on_container_copy_construction<const allocator_type>(), __a);
+      }
+
       template <class _Ptr>
       static
       void
@@ -536,6 +574,16 @@ namespace eoslib {
          return numeric_limits<size_type>::max() / sizeof(value_type);
       }
 
+      static allocator_type __select_on_container_copy_construction(true_type, const allocator_type& __a)
+      {
+         return __a.select_on_container_copy_construction();
+      }
+
+      static allocator_type __select_on_container_copy_construction(false_type, const allocator_type& __a)
+      {
+         return __a;
+      }
+
    };
 
    template <class _Tp>
@@ -655,5 +703,80 @@ namespace eoslib {
    inline
    bool operator!=(const allocator<_Tp>&, const allocator<_Up>&) { return false; }
 
+
+   // Source of memory for resource_allocator, such as a pool owned by a container of many small buffers.
+   class memory_resource
+   {
+   public:
+      virtual ~memory_resource() {}
+
+      virtual void* allocate(size_t __size) = 0;
+      virtual void  deallocate(void* __ptr, size_t __size) = 0;
+   };
+
+   // Allocator drawing from a memory_resource, or from operator new if it has none. Containers moved from one another take the resource
+   // with them, while copies of a container allocate from operator new unless given a resource explicitly.
+   template <class _Tp>
+   class resource_allocator
+   {
+   public:
+      using size_type       = size_t;
+      using difference_type = ptrdiff_t;
+      using pointer         = _Tp*;
+      using const_pointer   = const _Tp*;
+      using value_type      = _Tp;
+
+      using propagate_on_container_move_assignment = true_type;
+
+      template <class _Up> struct rebind {typedef resource_allocator<_Up> other;};
+
+      resource_allocator(memory_resource* __r = nullptr)
+         : __resource_(__r)
+      {}
+
+      template <class _Up>
+      resource_allocator(const resource_allocator<_Up>& __a)
+         : __resource_(__a.resource())
+      {}
+
+      pointer allocate(size_type __n)
+      {
+         if (__n > max_size())
+            EOS_ERROR(std::length_error, "resource_allocator<T>::allocate(size_t n) 'n' exceeds maximum supported size");
+
+         if (__resource_ == nullptr)
+            return static_cast<pointer>(__libcpp_allocate(__n * sizeof(_Tp)));
+         return static_cast<pointer>(__resource_->allocate(__n * sizeof(_Tp)));
+      }
+
+      void deallocate(pointer __p, size_type __n)
+      {
+         if (__resource_ == nullptr)
+            __libcpp_deallocate((void*)__p);
+         else
+            __resource_->deallocate((void*)__p, __n * sizeof(_Tp));
+      }
+
+      size_type max_size()const
+      {
+         return size_type(~0) / sizeof(_Tp);
+      }
+
+      resource_allocator select_on_container_copy_construction()const { return resource_allocator(); }
+
+      memory_resource* resource()const { return __resource_; }
+
+   private:
+      memory_resource* __resource_;
+   };
+
+   template <class _Tp, class _Up>
+   inline
+   bool operator==(const resource_allocator<_Tp>& __x, const resource_allocator<_Up>& __y) { return __x.resource() == __y.resource(); }
+
+   template <class _Tp, class _Up>
+   inline
+   bool operator!=(const resource_allocator<_Tp>& __x, const resource_allocator<_Up>& __y) { return !(__x == __y); }
+
 }
 
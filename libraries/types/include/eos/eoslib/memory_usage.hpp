@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace eos { namespace types {
+
+   // Memory held by a container, in bytes requested from its allocator (the bookkeeping of the allocator itself is not counted).
+   // used is what its elements take up, and reserved adds the unused capacity and any other overhead, so their difference is the slack.
+   struct memory_usage
+   {
+      uint64_t used     = 0;
+      uint64_t reserved = 0;
+
+      inline uint64_t get_slack()const { return reserved - used; }
+
+      inline memory_usage& operator+=(const memory_usage& other)
+      {
+         used     += other.used;
+         reserved += other.reserved;
+         return *this;
+      }
+   };
+
+   // Memory owned by a value outside of itself, e.g. the heap buffer of a string too long for its small string optimization.
+   template<typename T>
+   inline memory_usage owned_memory_usage(const T&)
+   {
+      return memory_usage();
+   }
+
+   inline memory_usage owned_memory_usage(const std::string& s)
+   {
+      auto self = reinterpret_cast<const char*>(&s);
+      if( !std::less<const char*>()(s.data(), self) && std::less<const char*>()(s.data(), self + sizeof(s)) )
+         return memory_usage(); // Stored within the string itself
+
+      memory_usage u;
+      u.used     = s.size() + 1;
+      u.reserved = s.capacity() + 1;
+      return u;
+   }
+
+   template<typename T1, typename T2>
+   inline memory_usage owned_memory_usage(const std::pair<T1, T2>& p)
+   {
+      auto u = owned_memory_usage(p.first);
+      u += owned_memory_usage(p.second);
+      return u;
+   }
+
+   // Memory held by a contiguous container (e.g. a vector or a flat_map) and by its elements.
+   template<typename Container>
+   memory_usage memory_usage_of(const Container& c)
+   {
+      memory_usage u;
+      u.used     = c.size() * sizeof(typename Container::value_type);
+      u.reserved = c.capacity() * sizeof(typename Container::value_type);
+      for( const auto& v : c )
+         u += owned_memory_usage(v);
+      return u;
+   }
+
+} }
@@ -4,6 +4,9 @@
 #include <eos/eoslib/type_traits.hpp>
 #include <eos/eoslib/exceptions.hpp>
 #include <eos/eoslib/vector.hpp>
+#include <eos/eoslib/compare_stats.hpp>
+
+#include <atomic>
 
 #ifdef EOS_TYPES_FULL_CAPABILITY
 #include <iosfwd>
@@ -20,37 +23,160 @@ namespace eos { namespace types {
 
    template <typename T> using Vector = eoslib::vector<T>;
 
+   using eoslib::memory_resource;
+   using region_allocator = eoslib::resource_allocator<byte>;
+   using region_data      = eoslib::vector<byte, region_allocator>;
+
+   class trusted_region;
+
+   // Read-only view of the data of a raw_region, which is valid until the region is changed or moved.
+   class raw_bytes
+   {
+   public:
+
+      raw_bytes(const byte* data, uint32_t size)
+         : _data(data), _size(size)
+      {}
+
+      inline const byte* data()const  { return _data; }
+      inline uint32_t    size()const  { return _size; }
+      inline const byte* begin()const { return _data; }
+      inline const byte* end()const   { return _data + _size; }
+
+      inline const byte& operator[](uint32_t i)const { return _data[i]; }
+
+   private:
+      const byte* _data;
+      uint32_t    _size;
+   };
+
+#ifndef EOS_TYPES_RAW_REGION_INLINE_CAPACITY
+#define EOS_TYPES_RAW_REGION_INLINE_CAPACITY 64
+#endif
+
+   // Data of up to inline_capacity bytes is stored within the region itself, so small fixed-size objects need no allocation.
+   // The data moves to an allocation once the region grows past inline_capacity (or reserves more than that), and stays there until the
+   // region is moved from, even if it is cleared, so that a region reused for serialization keeps its buffer.
+   // Alternatively, the data can be made immutable and shared (see share), so that copying the region only takes a reference to it.
    class raw_region
    {
       static const byte byte_masks[16];
 
+      friend class trusted_region;
+
+      // Immutable data shared by regions, followed by size bytes of data, and freed along with the last region referring to it.
+      // The count of references is atomic, so that regions sharing data can be copied and destroyed by different threads.
+      struct shared_buffer
+      {
+         std::atomic<uint32_t> refs;
+         uint32_t              size;
+
+         inline const byte* data()const { return reinterpret_cast<const byte*>(this + 1); }
+
+         static shared_buffer* make(const byte* data, uint32_t size);
+         static void           release(shared_buffer* b);
+      };
+
+      static const uint32_t shared_marker = 0xFFFFFFFF; // Value of inline_size while the data is shared
+
    public:
 
-      raw_region() {};
+      static const uint32_t inline_capacity = EOS_TYPES_RAW_REGION_INLINE_CAPACITY;
+
+      static_assert( inline_capacity > 0 && inline_capacity % 8 == 0, "Inline capacity of raw_region must be a positive multiple of 8" );
 
-      raw_region(const raw_region& other) = default;
-      raw_region& operator=(const raw_region& other) = default;
+      static const uint32_t shared_header_size = sizeof(shared_buffer); // Allocated along with shared data
+
+      raw_region()
+         : inline_size(0)
+      {}
+
+      // Empty region whose data will be allocated from resource (see memory_resource), which must outlive it and whatever it is moved into.
+      explicit raw_region(memory_resource* resource)
+         : allocated(region_allocator(resource)), inline_size(0)
+      {}
+
+      // Copy of other whose data (unless stored inline) is allocated from resource. Plain copies always allocate their data with operator new.
+      raw_region(const raw_region& other, memory_resource* resource)
+         : allocated(region_allocator(resource)), inline_size(0)
+      {
+         assign(other.data(), other.offset_end());
+      }
+
+      // Copies of a region whose data is shared share it as well.
+      raw_region(const raw_region& other)
+         : inline_size(0)
+      {
+         if( other.is_shared() )
+            share_with(other);
+         else
+            assign(other.data(), other.offset_end());
+      }
+
+      raw_region& operator=(const raw_region& other)
+      {
+         if( this == &other || (is_shared() && other.is_shared() && shared == other.shared) )
+            return *this;
+         if( other.is_shared() )
+         {
+            unshare_without_copy();
+            allocated = region_data(allocated.get_allocator()); // Frees the buffer, if any, but keeps the memory_resource
+            share_with(other);
+         }
+         else
+            assign(other.data(), other.offset_end());
+         return *this;
+      }
 
       raw_region(raw_region&& other)
-         : raw_data(move(other.raw_data))
+         : allocated(move(other.allocated)), inline_size(other.inline_size)
       {
-         other.raw_data.clear();
+         take_inline_or_shared(other);
       }
 
       raw_region& operator=(raw_region&& other)
       {
-         raw_data = move(other.raw_data);
-         other.raw_data.clear();
+         if( this != &other )
+         {
+            unshare_without_copy();
+            allocated   = move(other.allocated);
+            inline_size = other.inline_size;
+            take_inline_or_shared(other);
+         }
          return *this;
       }
 
-      inline const Vector<byte>& get_raw_data()const { return raw_data; }
+      ~raw_region()
+      {
+         unshare_without_copy();
+      }
+
+      inline raw_bytes        get_raw_data()const        { return raw_bytes(data(), offset_end()); }
+      inline memory_resource* get_memory_resource()const { return allocated.get_allocator().resource(); }
+
+      inline bool        is_shared()const  { return inline_size == shared_marker; }
+      inline bool        is_inline()const  { return allocated.data() == nullptr && !is_shared(); }
+
+      inline const byte* data()const
+      {
+         if( allocated.data() != nullptr )
+            return allocated.data();
+         return is_shared() ? shared->data() : inline_data;
+      }
+
+      inline uint32_t capacity()const   { return is_shared() ? shared->size : (is_inline() ? inline_capacity : allocated.capacity()); }
+      inline uint32_t offset_end()const { return is_shared() ? shared->size : (is_inline() ? inline_size : allocated.size()); }
 
-      inline uint32_t capacity()const   { return raw_data.capacity(); }
-      inline uint32_t offset_end()const { return raw_data.size(); }
+      // Moves the data into an immutable buffer shared by every copy of the region made from then on, so that copies no longer duplicate
+      // the data. Any change to a region (including through get of a reference) gives it its own copy of the data again first.
+      // The buffer is allocated with operator new rather than from the memory_resource of the region, since it may outlive the region.
+      void share();
 
       void reserve(uint32_t new_cap);
-      void extend(uint32_t new_offset_end);
+      void extend(uint32_t new_offset_end);               // The bytes added are zero
+      void extend_uninitialized(uint32_t new_offset_end); // The bytes added are left uninitialized, so the caller must write all of them
+      void zero_fill(uint32_t offset, uint32_t size);
+      void assign(const byte* data, uint32_t size); // Replaces the contents with a copy of size bytes at data
       void clear();
 
       template<typename T>
@@ -61,7 +187,8 @@ namespace eos { namespace types {
          if( offset + sizeof(T) > offset_end() )
             EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
 
-         return *reinterpret_cast<const T*>(raw_data.data() + offset);
+         EOS_TYPES_COMPARE_STATS_TOUCH(sizeof(T));
+         return *reinterpret_cast<const T*>(data() + offset);
       }
 
       template<typename T>
@@ -72,7 +199,7 @@ namespace eos { namespace types {
         if( offset + sizeof(T) > offset_end() )
             EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
 
-        return *reinterpret_cast<T*>(raw_data.data() + offset);
+        return *reinterpret_cast<T*>(mutable_data() + offset);
       }
 
       template<typename T>
@@ -83,7 +210,7 @@ namespace eos { namespace types {
          if( offset + sizeof(T) > offset_end() )
             EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
 
-         *reinterpret_cast<T*>(raw_data.data() + offset) = value;
+         *reinterpret_cast<T*>(mutable_data() + offset) = value;
       }
 
       template<typename T>
@@ -95,7 +222,8 @@ namespace eos { namespace types {
          if( offset >= offset_end() )
             EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
 
-         byte b = *reinterpret_cast<const byte*>(raw_data.data() + offset);
+         EOS_TYPES_COMPARE_STATS_TOUCH(1);
+         byte b = data()[offset];
          auto index = ((offset_in_bits & 7) << 1);
          return ((b & byte_masks[index]) != 0);
       }
@@ -109,7 +237,7 @@ namespace eos { namespace types {
          if( offset >= offset_end() )
             EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
 
-         byte& b = *reinterpret_cast<byte*>(raw_data.data() + offset);
+         byte& b = mutable_data()[offset];
          auto index = ((offset_in_bits & 7) << 1);
          if( value )
             b |= byte_masks[index];
@@ -124,7 +252,90 @@ namespace eos { namespace types {
 #endif
 
    private:
-      Vector<byte> raw_data;
+      region_data    allocated;   // Holds the data unless it is inline or shared (i.e. unless it has no buffer)
+      uint32_t       inline_size; // Or shared_marker
+      union
+      {
+         alignas(8) byte inline_data[inline_capacity];
+         shared_buffer*  shared;
+      };
+
+      inline byte* mutable_data()
+      {
+         if( is_shared() )
+            unshare();
+         return is_inline() ? inline_data : allocated.data();
+      }
+
+      void spill(uint32_t new_cap); // Moves inline data into an allocation of new_cap bytes
+
+      void unshare(); // Copies shared data into the region itself (or an allocation), leaving the buffer to its other regions
+
+      // Drops the reference to shared data, leaving the region empty and inline (as is the case once moved from).
+      inline void unshare_without_copy()
+      {
+         if( !is_shared() )
+            return;
+         shared_buffer::release(shared);
+         inline_size = 0;
+      }
+
+      // Requires other to be shared, and this region to be empty and inline.
+      inline void share_with(const raw_region& other)
+      {
+         other.shared->refs.fetch_add(1, std::memory_order_relaxed);
+         shared      = other.shared;
+         inline_size = shared_marker;
+      }
+
+      // Second half of moving other (whose inline_size has already been copied) into this region.
+      inline void take_inline_or_shared(raw_region& other)
+      {
+         if( other.is_shared() )
+            shared = other.shared;
+         else
+            memcpy(inline_data, other.inline_data, inline_size);
+         other.allocated.clear();
+         other.inline_size = 0;
+      }
+   };
+
+   // Read-only view of a raw_region whose layout has already been validated for the reads made through it (see compare_program::validate).
+   // Same accessors as raw_region, but without bounds checks.
+   class trusted_region
+   {
+   public:
+
+      explicit trusted_region(const raw_region& r)
+         : region(r), data(r.data())
+      {}
+
+      inline const raw_region& get_region()const { return region; }
+      inline const byte*       get_data()const   { return data; }
+
+      template<typename T>
+      inline
+      typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, T>::type
+      get( uint32_t offset )const
+      {
+         EOS_TYPES_COMPARE_STATS_TOUCH(sizeof(T));
+         return *reinterpret_cast<const T*>(data + offset);
+      }
+
+      template<typename T>
+      inline
+      typename enable_if<is_same<T, bool>::value, bool>::type
+      get( uint32_t offset_in_bits )const
+      {
+         EOS_TYPES_COMPARE_STATS_TOUCH(1);
+         byte b = data[offset_in_bits >> 3];
+         auto index = ((offset_in_bits & 7) << 1);
+         return ((b & raw_region::byte_masks[index]) != 0);
+      }
+
+   private:
+      const raw_region& region;
+      const byte*       data;
    };
 
 } }
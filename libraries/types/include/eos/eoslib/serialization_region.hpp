@@ -170,6 +170,24 @@ EOS_TYPES_CUSTOM_BUILTIN_MATCH_END
             }
          }
 
+         // Whether writing a value of type tid sets every byte of its stride, as is the case for integers and rationals.
+         static bool fills_stride(type_id tid, type_id::size_align sa)
+         {
+            if( tid.get_type_class() != type_id::builtin_type )
+               return false;
+
+            switch( tid.get_builtin_type() )
+            {
+               case type_id::builtin_bool:
+               case type_id::builtin_string:
+               case type_id::builtin_bytes:
+               case type_id::builtin_any:
+                  return false;
+               default:
+                  return sa.get_size() == sa.get_stride();
+            }
+         }
+
          template<class Container>
          void write_vector(const Container& c, bool write_zero_at_end = false)const
          {
@@ -186,9 +204,23 @@ EOS_TYPES_CUSTOM_BUILTIN_MATCH_END
             auto stride = sa.get_stride();
             auto align = sa.get_align();
             
-            uint32_t vector_data_offset = type_id::round_up_to_alignment(r.offset_end(), align);
-            r.extend( vector_data_offset + ( (write_zero_at_end ? num_elements + 1 : num_elements) * stride) );
-            r.set<uint32_t>(offset,   (write_zero_at_end ? num_elements + 1 : num_elements) );
+            uint32_t old_end            = r.offset_end();
+            uint32_t vector_data_offset = type_id::round_up_to_alignment(old_end, align);
+            uint32_t num_stored         = (write_zero_at_end ? num_elements + 1 : num_elements);
+            uint32_t vector_data_end    = vector_data_offset + num_stored * stride;
+
+            // The elements written below overwrite the new bytes anyway, so only those they leave untouched are zeroed: the alignment padding
+            // in front of the data and the terminating zero, or all of the data if the elements do not fill their strides.
+            r.extend_uninitialized(vector_data_end);
+            if( fills_stride(element_tid, sa) )
+            {
+               r.zero_fill(old_end, vector_data_offset - old_end);
+               r.zero_fill(vector_data_offset + num_elements * stride, (num_stored - num_elements) * stride);
+            }
+            else
+               r.zero_fill(old_end, vector_data_end - old_end);
+
+            r.set<uint32_t>(offset,   num_stored);
             r.set<uint32_t>(offset+4, vector_data_offset);
  
             write_visitor vis(tm, r, element_tid, vector_data_offset); 
@@ -259,7 +291,7 @@ EOS_TYPES_CUSTOM_BUILTIN_MATCH_END
          eos::types::reflector<PlainT>::visit(type, vis);
       }
 
-      inline const Vector<byte>& get_raw_data()const { return raw_data.get_raw_data(); }
+      inline raw_bytes get_raw_data()const { return raw_data.get_raw_data(); }
 
       inline const raw_region& get_raw_region()const { return raw_data; }
 
@@ -2,10 +2,13 @@
 
 #include <eos/eoslib/field_metadata.hpp>
 #include <eos/eoslib/raw_region.hpp>
+#include <eos/eoslib/compare_stats.hpp>
 
 #include <utility>
 #include <tuple>
 #include <vector>
+#include <type_traits>
+#include <limits>
 
 namespace eos { namespace types {
 
@@ -37,6 +40,38 @@ namespace eos { namespace types {
        return range<typename Container::const_iterator> (c.begin()+b, c.begin()+e);
    }
 
+   template<typename B>
+   inline
+   typename std::enable_if<std::is_integral<B>::value, int8_t>::type
+   compare_primitives(B lhs, B rhs)
+   {
+      if( lhs < rhs )
+         return -1;
+      else if( rhs < lhs )
+         return 1;
+      return 0;
+   }
+
+   // Orders rationals by lhs_numerator * rhs_denominator versus rhs_numerator * lhs_denominator (so a zero denominator makes a value infinite
+   // with the sign of its numerator, and 0/0 compares equal to everything), except that two zero denominators compare their numerators.
+   inline int8_t compare_rationals(int64_t lhs_numerator, uint64_t lhs_denominator, int64_t rhs_numerator, uint64_t rhs_denominator)
+   {
+      // Fast paths: equal denominators (e.g. prices with a fixed precision) and finite values of opposite signs.
+      if( lhs_denominator == rhs_denominator )
+         return compare_primitives(lhs_numerator, rhs_numerator);
+      if( (lhs_numerator < 0) != (rhs_numerator < 0) && lhs_denominator != 0 && rhs_denominator != 0 )
+         return (lhs_numerator < 0) ? -1 : 1;
+
+      __int128 x = static_cast<__int128>(lhs_numerator) * rhs_denominator;
+      __int128 y = static_cast<__int128>(rhs_numerator) * lhs_denominator;
+
+      if( x < y )
+         return -1;
+      else if( y < x )
+         return 1;
+      return 0;
+   }
+
    class types_manager_common
    {
    public:
@@ -44,6 +79,7 @@ namespace eos { namespace types {
       using sorted_window     = bit_view<bool,     31,  1, uint32_t>;
       using ascending_window  = bit_view<bool,     30,  1, uint32_t>;
       using unique_window     = bit_view<bool,     29,  1, uint32_t>;
+      using hashed_window     = bit_view<bool,     28,  1, uint32_t>;
       using index_type_window = bit_view<bool,     24,  1, uint32_t>;
       using index_window      = bit_view<uint32_t,  0, 24, uint32_t>;
 
@@ -57,10 +93,13 @@ namespace eos { namespace types {
 
          bool    is_unique()const;
          bool    is_ascending()const;
+         bool    is_hashed()const;
          type_id get_key_type()const;
          range<vector<field_metadata>::const_iterator> get_sorted_members()const;
 
          inline const types_manager_common& get_types_manager()const { return tm; }
+         inline type_id::index_t            get_table()const { return table; }
+         inline uint8_t                     get_index_seq_num()const { return index_seq_num; }
 
          friend class types_manager_common;
 
@@ -68,6 +107,8 @@ namespace eos { namespace types {
          const types_manager_common& tm;
          uint32_t index_info;
          uint32_t members_offset;
+         type_id::index_t table;
+         uint8_t index_seq_num;
          
          table_index(const types_manager_common& tm, type_id::index_t index, uint8_t index_seq_num);
       };
@@ -94,11 +135,15 @@ namespace eos { namespace types {
       type_id::index_t                                   get_struct_index_of_table_object(type_id::index_t index)const;
       table_index                                        get_table_index(type_id::index_t index, uint8_t index_seq_num)const;
 
-      int8_t                                             compare_object_with_key(const raw_region& object_data, const raw_region& key_data, const table_index& ti)const;
+      // Only the first num_key_members sorted members of the key are compared, which allows lookups by a prefix of a struct key.
+      int8_t                                             compare_object_with_key(const raw_region& object_data, const raw_region& key_data, const table_index& ti,
+                                                                                 uint16_t num_key_members = std::numeric_limits<uint16_t>::max())const;
       int8_t                                             compare_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs, const table_index& ti)const;
+      int8_t                                             compare_data(type_id tid, const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)const;
 
       friend class table_index;
       friend class types_constructor;
+      friend class compare_program;
 
       // Type traversal: (Caller needs to ensure types of types_manager_common is in a coherent state, or else things will go horribly wrong)
  
@@ -118,6 +163,8 @@ namespace eos { namespace types {
       template<typename Visitor>
       traversal_shortcut traverse_type(type_id tid, Visitor& v)const
       {
+         EOS_TYPES_COMPARE_STATS_DEPTH();
+
          if( tid.is_void() )
          {
             traversal_shortcut s = v();
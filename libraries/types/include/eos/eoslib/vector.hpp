@@ -179,6 +179,9 @@ namespace eoslib {
       void resize(size_type __sz);
       void resize(size_type __sz, const_reference __x);
 
+      // Like resize, but default-initializes the new elements, which leaves trivial ones (e.g. bytes) uninitialized. Not in std::vector.
+      void resize_default_init(size_type __sz);
+
       void swap(vector&);
 
    private:
@@ -216,6 +219,9 @@ namespace eoslib {
       void __append(size_type __n);
       void __append(size_type __n, const_reference __x);
 
+      void __move_assign(vector& __x, true_type);
+      void __move_assign(vector& __x, false_type);
+
    };
       
    //  Allocate space for __n objects
@@ -414,7 +420,7 @@ namespace eoslib {
 
    template <class _Tp, class _Allocator>
    vector<_Tp, _Allocator>::vector(const vector& __x)
-      : __begin_(nullptr), __end_(nullptr), __end_cap_(nullptr)
+      : __begin_(nullptr), __end_(nullptr), __end_cap_(nullptr), __alloc_(__alloc_traits::select_on_container_copy_construction(__x.__alloc_))
    {
       size_type __n = __x.size();
       if (__n > 0)
@@ -473,10 +479,18 @@ namespace eoslib {
    >::type
    vector<_Tp, _Allocator>::assign(_ForwardIterator __first, _ForwardIterator __last)
    {
-      // Lazy implementation. Not optimal.
-      clear();
-      for (; __first != __last; ++__first)
-         push_back(*__first);
+      size_type __n = 0;
+      for (_ForwardIterator __i = __first; __i != __last; ++__i)
+         ++__n;
+
+      if (__n > capacity())
+      {
+         deallocate();
+         allocate(__recommend(__n));
+      }
+      else
+         clear();
+      __alloc_traits::__construct_range_forward(__alloc_, __first, __last, __end_);
    }
 
    template <class _Tp, class _Allocator>
@@ -546,20 +560,47 @@ namespace eoslib {
       }
       else
       {
-         EOS_ERROR(std::runtime_error, "Not implemented");
+         assign(__x.__begin_, __x.__end_);
       }
    }
 
    template <class _Tp, class _Allocator>
    vector<_Tp, _Allocator>& 
    vector<_Tp, _Allocator>::operator=(vector&& __x)
+   {
+      __move_assign(__x, typename __alloc_traits::propagate_on_container_move_assignment());
+      return *this;
+   }
+
+   template <class _Tp, class _Allocator>
+   void
+   vector<_Tp, _Allocator>::__move_assign(vector& __x, true_type)
    {
       deallocate();
+      __alloc_   = move(__x.__alloc_);
       __begin_   = __x.__begin_;
       __end_     = __x.__end_;
       __end_cap_ = __x.__end_cap_;
       __x.__begin_ = __x.__end_ = __x.__end_cap_ = nullptr;
-      return *this;
+   }
+
+   //  Keeps the allocator of *this, so the buffer of __x can only be taken over if both allocators are interchangeable.
+   template <class _Tp, class _Allocator>
+   void
+   vector<_Tp, _Allocator>::__move_assign(vector& __x, false_type)
+   {
+      if (__alloc_ == __x.__alloc_)
+      {
+         deallocate();
+         __begin_   = __x.__begin_;
+         __end_     = __x.__end_;
+         __end_cap_ = __x.__end_cap_;
+         __x.__begin_ = __x.__end_ = __x.__end_cap_ = nullptr;
+      }
+      else
+      {
+         assign(__x.__begin_, __x.__end_);
+      }
    }
 
 
@@ -638,7 +679,7 @@ namespace eoslib {
    vector<_Tp, _Allocator>::push_back(const_reference __x)
    {
       if( __end_ == __end_cap_ )
-         __enlarge_buffer(size() + 1);
+         __enlarge_buffer(__recommend(size() + 1));
 
       __alloc_traits::construct(__alloc_, __to_raw_pointer(__end_), __x);
       ++__end_;
@@ -649,7 +690,7 @@ namespace eoslib {
    vector<_Tp, _Allocator>::push_back(value_type&& __x)
    {
       if( __end_ == __end_cap_ )
-         __enlarge_buffer(size() + 1);
+         __enlarge_buffer(__recommend(size() + 1));
 
       __alloc_traits::construct(__alloc_, __to_raw_pointer(__end_), move(__x));
       ++__end_;
@@ -661,7 +702,7 @@ namespace eoslib {
    vector<_Tp, _Allocator>::emplace_back(_Args&&... __args)
    {
       if( __end_ == __end_cap_ )
-         __enlarge_buffer(size() + 1);
+         __enlarge_buffer(__recommend(size() + 1));
 
       __alloc_traits::construct(__alloc_, __to_raw_pointer(__end_), forward<_Args>(__args)...);
       ++__end_;
@@ -698,6 +739,22 @@ namespace eoslib {
          __destruct_at_end(__begin_ + __sz);
    }
 
+   template <class _Tp, class _Allocator>
+   void
+   vector<_Tp, _Allocator>::resize_default_init(size_type __sz)
+   {
+      size_type __cs = size();
+      if (__cs < __sz)
+      {
+         if (static_cast<size_type>(__end_cap_ - __end_) < __sz - __cs)
+            __enlarge_buffer(__recommend(__sz));
+         for (pointer __new_end = __begin_ + __sz; __end_ != __new_end; ++__end_)
+            ::new ((void*)__to_raw_pointer(__end_)) _Tp;
+      }
+      else if (__cs > __sz)
+         __destruct_at_end(__begin_ + __sz);
+   }
+
    template <class _Tp, class _Allocator>
    void
    vector<_Tp, _Allocator>::swap(vector& __x)
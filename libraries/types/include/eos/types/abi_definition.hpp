@@ -43,6 +43,7 @@ namespace eos { namespace types {
          type_id          key_type;
          bool             unique;
          bool             ascending;
+         bool             hashed;    // Hashed indices must be unique and are not ordered (ascending is then ignored).
          vector<uint16_t> mapping;
      };
 
@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <iterator>
 #include <utility>
+#include <tuple>
 #include <vector>
 #include <array>
 #include <boost/optional.hpp>
@@ -21,6 +22,7 @@
 #include <boost/preprocessor/seq/size.hpp>
 #include <boost/preprocessor/seq/seq.hpp>
 #include <boost/preprocessor/tuple/elem.hpp>
+#include <boost/preprocessor/punctuation/comma_if.hpp>
 //#include <boost/preprocessor/repetition/repeat.hpp>
 //#include <boost/preprocessor/repetition/repeat_from_to.hpp>
 
@@ -29,6 +31,29 @@
 #undef EOS_TYPES_CREATE_TABLE
 #undef EOS_TYPES_REGISTER_TYPES
 
+namespace eos { namespace types {
+
+   // Compile-time description of a sorted member of a struct (see reflector<T>::sorted_members, and reflector<T>::tie_sorted_members
+   // which returns references to the sorted members of an instance in the same order).
+   template<typename T, bool Ascending>
+   struct sorted_member_info
+   {
+      using type         = T;
+      using is_ascending = std::integral_constant<bool, Ascending>;
+   };
+
+   // Compile-time description of an index of a table (see table_reflector<T>::indices).
+   template<typename Key, bool Unique, bool Ascending, bool Hashed>
+   struct index_reflector
+   {
+      using key_type     = Key;
+      using is_unique    = std::integral_constant<bool, Unique>;
+      using is_ascending = std::integral_constant<bool, Ascending>;
+      using is_hashed    = std::integral_constant<bool, Hashed>;
+   };
+
+} }
+
 
 EOS_TYPES_REFLECT_BUILTIN(std::vector<uint8_t>, builtin_bytes)
 EOS_TYPES_REFLECT_ARRAY(std::array)
@@ -85,6 +110,19 @@ bool const eos::types::reflector<T>::sorted_member_dir[BOOST_PP_SEQ_SIZE(member_
    BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_TRANSFORM(EOS_TYPES_REFLECT_SORT_ORDER, _, member_sort))                   \
 };
 
+#define EOS_TYPES_REFLECT_SORTED_MEMBER_INFO(r, T, i, elem)                                                   \
+   BOOST_PP_COMMA_IF(i) eos::types::sorted_member_info<EOS_TYPES_REFLECT_GET_MEMBER_TYPE(T, BOOST_PP_TUPLE_ELEM(2, 0, elem)), \
+                                                       EOS_TYPES_REFLECT_SORT_ORDER(r, _, elem)>
+
+#define EOS_TYPES_REFLECT_TIE_SORTED_MEMBER(r, v, i, elem) BOOST_PP_COMMA_IF(i) v.BOOST_PP_TUPLE_ELEM(2, 0, elem)
+
+#define EOS_TYPES_REFLECT_SORTED_MEMBERS(T, member_sort)                                                     \
+      using sorted_members = std::tuple<BOOST_PP_SEQ_FOR_EACH_I(EOS_TYPES_REFLECT_SORTED_MEMBER_INFO, T, member_sort)>; \
+      static inline auto tie_sorted_members(const T& _v)                                                     \
+      {                                                                                                      \
+         return std::tie(BOOST_PP_SEQ_FOR_EACH_I(EOS_TYPES_REFLECT_TIE_SORTED_MEMBER, _v, member_sort));     \
+      }
+
 #define EOS_TYPES_REFLECT_INCREMENTER(r, op, elem ) op 1 
 
 #define EOS_TYPES_REFLECT_MEMBER_COUNT(fields, member_sort)                                                  \
@@ -185,6 +223,7 @@ EOS_TYPES_REFLECT_STRUCT_END(T, fields)
 #define EOS_TYPES_REFLECT_STRUCT_3(T, fields, member_sort)                                                   \
 EOS_TYPES_REFLECT_STRUCT_START(T)                                                                            \
 EOS_TYPES_REFLECT_MEMBER_COUNT(fields, member_sort)                                                          \
+EOS_TYPES_REFLECT_SORTED_MEMBERS(T, member_sort)                                                             \
 EOS_TYPES_REFLECT_GET_MEMBER_INFO(fields, member_sort)                                                       \
 EOS_TYPES_REFLECT_STRUCT_END(T, fields)                         
 
@@ -274,10 +313,11 @@ EOS_TYPES_REFLECT_STRUCT_DERIVED_END(T, B, fields)
    BOOST_PP_CAT(BOOST_PP_OVERLOAD(EOS_TYPES_REFLECT_STRUCT_DERIVED_,__VA_ARGS__)(__VA_ARGS__),BOOST_PP_EMPTY())
 #endif
 
-#define EOS_TYPES_REFLECT_INDEX_TYPE_u_asc true, true
-#define EOS_TYPES_REFLECT_INDEX_TYPE_u_desc true, false
-#define EOS_TYPES_REFLECT_INDEX_TYPE_nu_asc false, true
-#define EOS_TYPES_REFLECT_INDEX_TYPE_nu_desc false, false
+#define EOS_TYPES_REFLECT_INDEX_TYPE_u_asc true, true, false
+#define EOS_TYPES_REFLECT_INDEX_TYPE_u_desc true, false, false
+#define EOS_TYPES_REFLECT_INDEX_TYPE_nu_asc false, true, false
+#define EOS_TYPES_REFLECT_INDEX_TYPE_nu_desc false, false, false
+#define EOS_TYPES_REFLECT_INDEX_TYPE_u_hash true, true, true
 
 #define EOS_TYPES_REFLECT_VISIT_INDEX(r, data, i, index)                                                     \
    { vector<uint16_t> mapping BOOST_PP_TUPLE_ELEM(3, 2, index);                                              \
@@ -288,6 +328,10 @@ EOS_TYPES_REFLECT_STRUCT_DERIVED_END(T, B, fields)
 #define EOS_TYPES_REFLECT_VISIT_TABLE_END(T) \
   _v.TEMPLATE operator()<T>(true);
 
+#define EOS_TYPES_REFLECT_INDEX_REFLECTOR(r, data, i, index)                                                 \
+   BOOST_PP_COMMA_IF(i) eos::types::index_reflector<BOOST_PP_TUPLE_ELEM(3, 0, index),                        \
+                                                    BOOST_PP_CAT(EOS_TYPES_REFLECT_INDEX_TYPE_,BOOST_PP_TUPLE_ELEM(3, 1, index))>
+
 #define EOS_TYPES_CREATE_TABLE(T, INDICES)                                                                   \
 namespace eos { namespace types {                                                                            \
    template <>                                                                                               \
@@ -296,6 +340,7 @@ namespace eos { namespace types {
    {                                                                                                         \
       using is_defined = std::true_type;                                                                     \
       using type       = T;                                                                                  \
+      using indices    = std::tuple<BOOST_PP_SEQ_FOR_EACH_I(EOS_TYPES_REFLECT_INDEX_REFLECTOR, _, INDICES)>;   \
       template<typename Visitor>                                                                             \
       static void visit(Visitor& _v)                                                                         \
       {                                                                                                      \
@@ -373,18 +418,18 @@ namespace eos { namespace types {
 
       template<typename B>
       typename std::enable_if<eos::types::reflector<B>::is_builtin::value>::type
-      operator()(bool unique, bool ascending, const vector<uint16_t>& mapping) // Table index of builtin key type
+      operator()(bool unique, bool ascending, bool hashed, const vector<uint16_t>& mapping) // Table index of builtin key type
       {
          tid = type_id(eos::types::reflector<B>::builtin_type);
-         indices.push_back(ABI::table_index{ .key_type = tid, .unique = unique, .ascending = ascending, .mapping =  mapping });
+         indices.push_back(ABI::table_index{ .key_type = tid, .unique = unique, .ascending = ascending, .hashed = hashed, .mapping =  mapping });
       }
 
       template<class Class>
       typename std::enable_if<eos::types::reflector<Class>::is_product_type::value>::type
-      operator()(bool unique, bool ascending, const vector<uint16_t>& mapping) // Table index of struct or tuple/pair key type
+      operator()(bool unique, bool ascending, bool hashed, const vector<uint16_t>& mapping) // Table index of struct or tuple/pair key type
       {
          eos::types::reflector<Class>::visit(*this); // Should modify tid to be the type_id of Class
-         indices.push_back(ABI::table_index{ .key_type = tid, .unique = unique, .ascending = ascending, .mapping =  mapping });
+         indices.push_back(ABI::table_index{ .key_type = tid, .unique = unique, .ascending = ascending, .hashed = hashed, .mapping =  mapping });
       }
 
       template<class Class>
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <eos/eoslib/types_manager_common.hpp>
+#include <eos/eoslib/memory_usage.hpp>
 
+#include <iosfwd>
 #include <string>
 #include <boost/container/flat_map.hpp>
 
@@ -13,6 +15,17 @@ namespace eos { namespace types {
    class types_manager : public types_manager_common
    {
    public:
+
+      // Memory held by each container of a types_manager (see memory_usage).
+      struct memory_breakdown
+      {
+         memory_usage types;
+         memory_usage members;
+         memory_usage table_lookup;
+
+         memory_usage get_total()const;
+         void         print(std::ostream& os)const;
+      };
  
       types_manager(const types_manager& other)
          : types_manager_common(types, members), 
@@ -30,6 +43,12 @@ namespace eos { namespace types {
       
       type_id::index_t get_table(const string& name)const;
 
+      // Hash of the definitions of all types and tables, which is stable across processes and platforms.
+      // Two types_managers with the same fingerprint lay out and order the objects of their tables the same way.
+      uint64_t get_fingerprint()const;
+
+      memory_breakdown get_memory_usage()const;
+
       friend class types_constructor;
 
    private:
@@ -1,6 +1,8 @@
 #include <eos/eoslib/raw_region.hpp>
 #include <eos/eoslib/field_metadata.hpp>
 
+#include <new>
+
 #ifdef EOS_TYPES_FULL_CAPABILITY
 #include <ostream>
 #include <iomanip>
@@ -18,27 +20,149 @@ namespace eos { namespace types {
                                             0x40, 0xBF,
                                             0x80, 0x7F };
 
+   const uint32_t raw_region::inline_capacity;
+   const uint32_t raw_region::shared_marker;
+   const uint32_t raw_region::shared_header_size;
+
+   static_assert( raw_region::shared_header_size % 8 == 0, "Shared data must be as aligned as inline data" );
+
+   raw_region::shared_buffer* raw_region::shared_buffer::make(const byte* data, uint32_t size)
+   {
+      auto b = new (eoslib::__libcpp_allocate(sizeof(shared_buffer) + size)) shared_buffer;
+      b->refs.store(1, std::memory_order_relaxed);
+      b->size = size;
+      if( size > 0 )
+         memcpy(reinterpret_cast<byte*>(b + 1), data, size);
+      return b;
+   }
+
+   void raw_region::shared_buffer::release(shared_buffer* b)
+   {
+      if( b->refs.fetch_sub(1, std::memory_order_acq_rel) != 1 )
+         return;
+      b->~shared_buffer();
+      eoslib::__libcpp_deallocate(b);
+   }
+
+   void raw_region::share()
+   {
+      if( is_shared() )
+         return;
+      auto b = shared_buffer::make(data(), offset_end());
+      allocated   = region_data(allocated.get_allocator()); // Frees the buffer, if any, but keeps the memory_resource
+      shared      = b;
+      inline_size = shared_marker;
+   }
+
+   void raw_region::unshare()
+   {
+      auto b = shared;
+      inline_size = 0;
+      assign(b->data(), b->size);
+      shared_buffer::release(b);
+   }
+
+   void raw_region::spill(uint32_t new_cap)
+   {
+      allocated.reserve(new_cap);
+      allocated.assign(inline_data, inline_data + inline_size);
+      inline_size = 0;
+   }
+
    void raw_region::reserve(uint32_t new_cap)
    {
       if( new_cap >= field_metadata::offset_limit )
          new_cap = field_metadata::offset_limit;
-      raw_data.reserve(new_cap);
+      if( is_shared() )
+         unshare();
+      if( new_cap <= capacity() )
+         return;
+      if( is_inline() )
+         spill(new_cap);
+      else
+         allocated.reserve(new_cap);
    }
 
    void raw_region::extend(uint32_t new_offset_end)
    {
       if( new_offset_end >= field_metadata::offset_limit )
          EOS_ERROR(std::invalid_argument, "Cannot enlarge raw region to that large of a size.");
-      if( new_offset_end <= raw_data.size() )
+      if( new_offset_end <= offset_end() )
          return;
-      raw_data.resize(new_offset_end);
+      if( is_shared() )
+         unshare();
+      if( is_inline() )
+      {
+         if( new_offset_end <= inline_capacity )
+         {
+            memset(inline_data + inline_size, 0, new_offset_end - inline_size);
+            inline_size = new_offset_end;
+            return;
+         }
+         spill(new_offset_end);
+      }
+      allocated.resize(new_offset_end);
+   }
+
+   void raw_region::extend_uninitialized(uint32_t new_offset_end)
+   {
+      if( new_offset_end >= field_metadata::offset_limit )
+         EOS_ERROR(std::invalid_argument, "Cannot enlarge raw region to that large of a size.");
+      if( new_offset_end <= offset_end() )
+         return;
+      if( is_shared() )
+         unshare();
+      if( is_inline() )
+      {
+         if( new_offset_end <= inline_capacity )
+         {
+            inline_size = new_offset_end;
+            return;
+         }
+         spill(new_offset_end);
+      }
+      allocated.resize_default_init(new_offset_end);
+   }
+
+   void raw_region::zero_fill(uint32_t offset, uint32_t size)
+   {
+      if( offset > offset_end() || size > offset_end() - offset )
+         EOS_ERROR(std::out_of_range, "Range to fill extends past the end of the region.");
+      if( size > 0 )
+         memset(mutable_data() + offset, 0, size);
+   }
+
+   void raw_region::assign(const byte* data, uint32_t size)
+   {
+      if( size >= field_metadata::offset_limit )
+         EOS_ERROR(std::invalid_argument, "Cannot enlarge raw region to that large of a size.");
+      if( is_shared() )
+      {
+         // data may point into the shared buffer, so it is only released once the data has been copied.
+         auto b = shared;
+         inline_size = 0;
+         assign(data, size);
+         shared_buffer::release(b);
+         return;
+      }
+      if( is_inline() && size <= inline_capacity )
+      {
+         if( size > 0 )
+            memmove(inline_data, data, size); // data may point into this region
+         inline_size = size;
+         return;
+      }
+      allocated.assign(data, data + size);
+      inline_size = 0;
    }
 
    void raw_region::clear()
    {
-      raw_data.clear();
+      unshare_without_copy();
+      allocated.clear();
+      inline_size = 0;
    }
-   
+
 #ifdef EOS_TYPES_FULL_CAPABILITY
    void raw_region::print_raw_data(std::ostream& os, uint32_t offset, uint32_t size)const
    {
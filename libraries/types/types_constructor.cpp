@@ -933,6 +933,7 @@ namespace eos { namespace types {
       
       using unique_window     = types_manager_common::unique_window;
       using ascending_window  = types_manager_common::ascending_window;
+      using hashed_window     = types_manager_common::hashed_window;
       using index_type_window = types_manager_common::index_type_window;
       using index_window      = types_manager_common::index_window;
 
@@ -963,8 +964,11 @@ namespace eos { namespace types {
             uint32_t minimal_members_offset = 0;
             uint32_t full_members_offset = 0;
             uint32_t storage = 0;
+            if( ti.hashed && !ti.unique )
+               throw std::invalid_argument("Hashed indices must be unique.");
             unique_window::set(storage, ti.unique);
             ascending_window::set(storage, ti.ascending);
+            hashed_window::set(storage, ti.hashed);
             auto tc = ti.key_type.get_type_class();
             if( tc == type_id::builtin_type )
             {
@@ -1,5 +1,7 @@
 #include <eos/types/types_manager.hpp>
 
+#include <ostream>
+
 namespace eos { namespace types {
 
    type_id::index_t types_manager::get_table(const string& name)const
@@ -11,5 +13,57 @@ namespace eos { namespace types {
       return itr->second;
    }
 
-} }
+   uint64_t types_manager::get_fingerprint()const
+   {
+      // FNV-1a over the encoded types followed by the storage of the members.
+      uint64_t h = 0xcbf29ce484222325ull;
+      auto mix = [&](uint64_t v, uint32_t num_bytes)
+      {
+         for( uint32_t i = 0; i < num_bytes; ++i, v >>= 8 )
+         {
+            h ^= (v & 0xFF);
+            h *= 0x100000001b3ull;
+         }
+      };
+
+      mix(types.size(), 4);
+      for( auto t : types )
+         mix(t, 4);
+      mix(members.size(), 4);
+      for( const auto& m : members )
+         mix(m.get_storage(), 8);
+      return h;
+   }
+
+   types_manager::memory_breakdown types_manager::get_memory_usage()const
+   {
+      memory_breakdown b;
+      b.types        = memory_usage_of(types);
+      b.members      = memory_usage_of(members);
+      b.table_lookup = memory_usage_of(table_lookup);
+      return b;
+   }
 
+   memory_usage types_manager::memory_breakdown::get_total()const
+   {
+      auto total = types;
+      total += members;
+      total += table_lookup;
+      return total;
+   }
+
+   void types_manager::memory_breakdown::print(std::ostream& os)const
+   {
+      auto line = [&](const char* name, const memory_usage& u)
+      {
+         os << "   " << name << ": " << u.used << " bytes used, " << u.reserved << " reserved" << std::endl;
+      };
+
+      auto total = get_total();
+      os << "types_manager: " << total.used << " bytes used, " << total.reserved << " reserved" << std::endl;
+      line("types", types);
+      line("members", members);
+      line("table_lookup", table_lookup);
+   }
+
+} }
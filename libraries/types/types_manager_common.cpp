@@ -1,4 +1,5 @@
 #include <eos/eoslib/types_manager_common.hpp>
+#include <eos/eoslib/compare_kernels.hpp>
 #include <eos/eoslib/exceptions.hpp>
 
 namespace eos { namespace types {
@@ -321,7 +322,7 @@ namespace eos { namespace types {
    }
 
    types_manager_common::table_index::table_index(const types_manager_common& tm, type_id::index_t index, uint8_t index_seq_num)
-      : tm(tm)
+      : tm(tm), table(index), index_seq_num(index_seq_num)
    {
       if( index + 1 + 2*(index_seq_num+1) > tm.types.size() )
          EOS_ERROR(std::invalid_argument, "Table index is not valid.");
@@ -347,6 +348,11 @@ namespace eos { namespace types {
       return ascending_window::get(index_info);
    }
 
+   bool types_manager_common::table_index::is_hashed()const
+   {
+      return hashed_window::get(index_info);
+   }
+
    type_id types_manager_common::table_index::get_key_type()const
    {
       if( index_type_window::get(index_info) )
@@ -365,18 +371,6 @@ namespace eos { namespace types {
       return make_range(tm.members, members_offset, members_offset + num_sorted_members); 
    }
 
-   template<typename B>
-   inline
-   typename std::enable_if<std::is_integral<B>::value, int8_t>::type
-   compare_primitives(B lhs, B rhs)
-   {
-      if( lhs < rhs )
-         return -1;
-      else if( rhs < lhs )
-         return 1;
-      return 0;
-   }
-
    struct compare_visitor
    {
       const types_manager_common& tm;
@@ -443,28 +437,8 @@ namespace eos { namespace types {
                break;
             case type_id::builtin_rational:
             {
-               auto lhs_numerator   = lhs.get<int64_t>(lhs_offset);
-               auto lhs_denominator = lhs.get<uint64_t>(lhs_offset+8);
-               auto rhs_numerator   = rhs.get<int64_t>(rhs_offset);
-               auto rhs_denominator = rhs.get<uint64_t>(rhs_offset+8);
-
-               if( lhs_denominator == 0 && rhs_denominator == 0 )
-               {
-                  if( lhs_numerator < rhs_numerator )
-                     comparison_result = -1;
-                  else if( rhs_numerator < lhs_numerator )
-                     comparison_result = 1;
-               }
-               else
-               {
-                  __int128 x = static_cast<__int128>(lhs_numerator) * rhs_denominator;
-                  __int128 y = static_cast<__int128>(rhs_numerator) * lhs_denominator;
-
-                  if( x < y )
-                     comparison_result = -1;
-                  else if( y < x )
-                     comparison_result = 1;
-               }
+               comparison_result = compare_rationals(lhs.get<int64_t>(lhs_offset),  lhs.get<uint64_t>(lhs_offset+8),
+                                                     rhs.get<int64_t>(rhs_offset),  rhs.get<uint64_t>(rhs_offset+8));
                break;
             }
             case type_id::builtin_any:
@@ -505,30 +479,7 @@ namespace eos { namespace types {
 
          if( is_string_or_bytes )
          {
-            auto lhs_num_elements = lhs.get<uint32_t>(lhs_offset);
-            auto rhs_num_elements = rhs.get<uint32_t>(rhs_offset);
-            auto num_elements = std::min(lhs_num_elements, rhs_num_elements);
-
-            lhs_offset = lhs.get<uint32_t>(lhs_offset+4);
-            rhs_offset = rhs.get<uint32_t>(rhs_offset+4);
-            for( uint32_t i = 0; i < num_elements; ++i )
-            {
-               comparison_result = compare_primitives(lhs.get<uint8_t>(lhs_offset), rhs.get<uint8_t>(rhs_offset));
-
-               if( comparison_result != 0 )
-                  break;
-
-               ++lhs_offset;
-               ++rhs_offset;
-            }
-
-            if( comparison_result == 0 )
-            {
-               if( lhs_num_elements < rhs_num_elements )
-                  comparison_result = -1;
-               else if( lhs_num_elements > rhs_num_elements )
-                  comparison_result = 1;
-            }
+            comparison_result = compare_integer_runs_at(type_id::builtin_uint8, lhs_offset, rhs_offset);
          }
 
          comparison_result = (ascending ? comparison_result : -comparison_result);
@@ -575,6 +526,13 @@ namespace eos { namespace types {
 
       traversal_shortcut operator()(vector_type t) 
       {
+         if( t.element_type.get_type_class() == type_id::builtin_type && get_builtin_integer_size(t.element_type.get_builtin_type()) > 0 )
+         {
+            auto c = compare_integer_runs_at(t.element_type.get_builtin_type(), lhs_offset, rhs_offset);
+            comparison_result = (ascending ? c : -c);
+            return types_manager_common::no_deeper;
+         }
+
          auto sa = tm.get_size_align(t.element_type);
          auto stride = sa.get_stride();
 
@@ -634,11 +592,27 @@ namespace eos { namespace types {
          else if( lhs_which > rhs_which )
             comparison_result = (ascending ? 1 : -1);
          else
-            tm.traverse_type(tm.get_variant_case_type(tid, t.index), *this);
+            tm.traverse_type(tm.get_variant_case_type(tid, lhs_which), *this);
 
          return types_manager_common::no_deeper;
       }
      
+      // Compares the strings, bytes or vectors of the builtin integer type b whose headers are at lhs_header_offset and rhs_header_offset.
+      int8_t compare_integer_runs_at(type_id::builtin b, uint32_t lhs_header_offset, uint32_t rhs_header_offset)const
+      {
+         auto lhs_num_elements = lhs.get<uint32_t>(lhs_header_offset);
+         auto rhs_num_elements = rhs.get<uint32_t>(rhs_header_offset);
+         auto lhs_data_offset  = lhs.get<uint32_t>(lhs_header_offset+4);
+         auto rhs_data_offset  = rhs.get<uint32_t>(rhs_header_offset+4);
+         uint64_t num_bytes = static_cast<uint64_t>(std::min(lhs_num_elements, rhs_num_elements)) * get_builtin_integer_size(b);
+
+         if( num_bytes > 0 && (lhs_data_offset + num_bytes > lhs.offset_end() || rhs_data_offset + num_bytes > rhs.offset_end()) )
+            EOS_ERROR(std::out_of_range, "Offset puts type outside of current range.");
+
+         return compare_builtin_integer_runs(b, lhs.get_raw_data().data() + lhs_data_offset, lhs_num_elements,
+                                                rhs.get_raw_data().data() + rhs_data_offset, rhs_num_elements);
+      }
+
       traversal_shortcut operator()() 
       {
          EOS_ERROR(std::runtime_error, "Invariant failure: Void type should not be allowed in structs or table keys.");
@@ -646,8 +620,12 @@ namespace eos { namespace types {
       }
    };
 
-   int8_t types_manager_common::compare_object_with_key(const raw_region& object_data, const raw_region& key_data, const table_index& ti)const
+   int8_t types_manager_common::compare_object_with_key(const raw_region& object_data, const raw_region& key_data, const table_index& ti,
+                                                        uint16_t num_key_members)const
    {
+      if( num_key_members == 0 )
+         return 0;
+
       auto object_range = ti.get_sorted_members();
       auto key_type = ti.get_key_type();
       auto tc = key_type.get_type_class();
@@ -670,6 +648,9 @@ namespace eos { namespace types {
       if( num_sorted_members != (object_range.end() - object_range.begin()) )
          EOS_ERROR(std::runtime_error, "Invariant failure: Number of sorted members of key and key-shaped view into the object are not the same.");
 
+      if( num_key_members < num_sorted_members )
+         num_sorted_members = num_key_members;
+
       for( auto i = 0; i < num_sorted_members; ++i )
       {
          auto f     = *(object_range.begin() + i);
@@ -695,6 +676,8 @@ namespace eos { namespace types {
 
    int8_t types_manager_common::compare_objects(uint64_t lhs_id, const raw_region& lhs, uint64_t rhs_id, const raw_region& rhs, const table_index& ti)const
    {
+      EOS_TYPES_COMPARE_STATS_SCOPE(get_compare_stats(*this, ti.get_table(), ti.get_index_seq_num()), false);
+
       int8_t comparison_result = 0;
       
       for( auto f : ti.get_sorted_members() )
@@ -713,12 +696,19 @@ namespace eos { namespace types {
       {
          if( lhs_id < rhs_id )
             comparison_result = -1;
-         else if( rhs_id > lhs_id )
+         else if( lhs_id > rhs_id )
             comparison_result = 1;
       }
 
       return comparison_result;
    }
 
+   int8_t types_manager_common::compare_data(type_id tid, const raw_region& lhs, uint32_t lhs_offset, const raw_region& rhs, uint32_t rhs_offset)const
+   {
+      compare_visitor v(*this, lhs, lhs_offset, rhs, rhs_offset, true);
+      traverse_type(tid, v);
+      return v.comparison_result;
+   }
+
 } }
 
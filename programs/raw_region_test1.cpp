@@ -0,0 +1,110 @@
+// Checks the storage of raw_region: inline data, spilling into an allocation, and shared data with copy-on-write.
+// Prints each check and exits with a non-zero status if any of them fails.
+
+#include "test_checks.hpp"
+
+#include <eos/eoslib/raw_region.hpp>
+
+#include <algorithm>
+#include <utility>
+
+using namespace eos::types;
+using test_checks::check;
+
+namespace {
+
+   // Region of size bytes counting up from first.
+   raw_region make_region(uint32_t size, uint8_t first)
+   {
+      raw_region r;
+      r.extend(size);
+      for( uint32_t i = 0; i < size; ++i )
+         r.set<uint8_t>(i, static_cast<uint8_t>(first + i));
+      return r;
+   }
+
+   bool same_data(const raw_region& lhs, const raw_region& rhs)
+   {
+      auto l = lhs.get_raw_data();
+      auto r = rhs.get_raw_data();
+      return l.size() == r.size() && std::equal(l.begin(), l.end(), r.begin());
+   }
+
+}
+
+int main()
+{
+   const uint32_t small = raw_region::inline_capacity / 2;
+   const uint32_t large = raw_region::inline_capacity * 4;
+
+   {
+      auto r = make_region(small, 1);
+      check(r.is_inline() && r.offset_end() == small && r.capacity() == raw_region::inline_capacity, "small data is stored inline");
+
+      raw_region copy = r;
+      check(copy.is_inline() && same_data(copy, r), "copy of inline data is inline");
+
+      raw_region moved = std::move(copy);
+      check(moved.is_inline() && same_data(moved, r) && copy.offset_end() == 0, "move of inline data empties the source");
+
+      r.extend(large);
+      check(!r.is_inline() && r.offset_end() == large && r.get<uint8_t>(0) == 1 && r.get<uint8_t>(small) == 0,
+            "growing past the inline capacity spills the data");
+
+      r.clear();
+      check(!r.is_inline() && r.offset_end() == 0, "cleared region keeps its allocation");
+   }
+
+   {
+      auto r = make_region(large, 7);
+      raw_region copy = r;
+      check(!copy.is_inline() && copy.data() != r.data() && same_data(copy, r), "copy of spilled data is a separate allocation");
+
+      raw_region moved = std::move(copy);
+      check(same_data(moved, r) && copy.offset_end() == 0 && copy.is_inline(), "move of spilled data takes the allocation");
+   }
+
+   for( auto size : {0u, small, large} )
+   {
+      auto original = make_region(size, 3);
+      auto r        = original;
+      r.share();
+      check(r.is_shared() && !r.is_inline() && same_data(r, original), "shared region keeps its data");
+
+      raw_region copy = r;
+      check(copy.is_shared() && copy.data() == r.data(), "copy of shared region refers to the same data");
+
+      raw_region moved = std::move(copy);
+      check(moved.is_shared() && moved.data() == r.data() && !copy.is_shared() && copy.offset_end() == 0, "move of shared region takes the reference");
+
+      if( size > 0 )
+      {
+         moved.set<uint8_t>(0, 99);
+         check(!moved.is_shared() && moved.get<uint8_t>(0) == 99 && same_data(r, original), "changing a copy of shared data leaves the others unchanged");
+      }
+
+      raw_region grown = r;
+      grown.extend(size + 8);
+      check(!grown.is_shared() && grown.offset_end() == size + 8 && same_data(r, original), "extending a copy of shared data copies it first");
+
+      raw_region inline_target = make_region(small, 50);
+      inline_target = r;
+      check(inline_target.is_shared() && inline_target.data() == r.data() && same_data(inline_target, original),
+            "copy-assigning shared data into an inline region shares it");
+
+      raw_region allocated_target = make_region(large, 90);
+      allocated_target = r;
+      check(allocated_target.is_shared() && allocated_target.data() == r.data() && same_data(allocated_target, original),
+            "copy-assigning shared data into a region with its own allocation shares it");
+
+      allocated_target = make_region(large, 90);
+      check(!allocated_target.is_shared() && allocated_target.offset_end() == large && same_data(r, original),
+            "assigning other data to a shared region drops its reference");
+
+      raw_region cleared = r;
+      cleared.clear();
+      check(!cleared.is_shared() && cleared.offset_end() == 0 && same_data(r, original), "clearing a shared region drops its reference");
+   }
+
+   return test_checks::report();
+}
@@ -60,10 +60,11 @@ EOS_TYPES_REFLECT_STRUCT( type3, (x)(y), ((x, asc))((y, asc)) )
 EOS_TYPES_CREATE_TABLE( type1,  ((uint32_t, nu_asc, ({0}) ))((type3,    u_desc,     ({1,0})   )) )
 //                      object, sequence of index tuples:   ((key_type, index_type, (mapping) )) where: mapping is a list (in curly brackets) of uint16_t member indices 
 //                                                                                                        which map the key_type's sort members (specified in that order) to the object type's members,
-//                                                                                               and    index_type = { u_asc,  // unique index sorted according to key_type in ascending order
-//                                                                                                                     u_desc, // unique index sorted according to key_type in descending order
-//                                                                                                                     nu_asc, // non-unique index sorted according to key_type in ascending order
-//                                                                                                                     nu_desc // non-unique index sorted according to key_type in descending order
+//                                                                                               and    index_type = { u_asc,   // unique index sorted according to key_type in ascending order
+//                                                                                                                     u_desc,  // unique index sorted according to key_type in descending order
+//                                                                                                                     nu_asc,  // non-unique index sorted according to key_type in ascending order
+//                                                                                                                     nu_desc, // non-unique index sorted according to key_type in descending order
+//                                                                                                                     u_hash   // unique index that is not sorted and only supports exact-match lookups of key_type
 //                                                                                                                   }    
 
 
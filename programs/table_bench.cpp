@@ -0,0 +1,508 @@
+// Measures the throughput and latency of the operations of dynamic tables for a set of key shapes.
+//
+// Usage: table_bench [--rows N] [--indices 1|3|6] [--shape all|u64|composite|string|vector|desc] [--engine all|bmi|static|ordered|btree] [--seed S]
+//
+// Every table has the key shape under test as its first index, followed by additional non-unique indices on other fields (up to the
+// requested number of indices) whose upkeep is part of the cost of inserts, modifies and erases. Engines:
+//    bmi     - dynamic_table_N (Boost.MultiIndex with dynamic_object_compare)
+//    static  - static_dynamic_table (Boost.MultiIndex with comparators specialized at compile time, see static_object_compare)
+//    ordered - dynamic_table with index_kind::ordered
+//    btree   - dynamic_table with index_kind::btree
+// Each scan operation is a full pass over the first index.
+// Rows are generated deterministically from the seed, so runs with the same arguments operate on the same data.
+// Build with optimizations (e.g. -DCMAKE_BUILD_TYPE=Release) for meaningful numbers. If built with -DEOS_TYPES_COMPARE_STATS=ON, the
+// comparison stats of each index (see eos/eoslib/compare_stats.hpp) are printed after each engine.
+
+#include <eos/eoslib/serialization_region.hpp>
+#include <eos/types/abi_constructor.hpp>
+#include <eos/types/types_constructor.hpp>
+#include <eos/types/types_manager.hpp>
+#include <eos/eoslib/full_types_manager.hpp>
+#include <eos/types/reflect.hpp>
+#include <eos/table/dynamic_table.hpp>
+#include <eos/table/static_object_compare.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using std::vector;
+using std::string;
+
+struct bench_pair
+{
+   uint32_t a;
+   uint64_t b;
+};
+
+EOS_TYPES_REFLECT_STRUCT( bench_pair, (a)(b), ((a, asc))((b, asc)) )
+
+// All tables share the same row layout but each needs its own struct type.
+#define BENCH_ROW( name )                                                                     \
+   struct name                                                                                \
+   {                                                                                          \
+      uint64_t         k;                                                                     \
+      uint32_t         a;                                                                     \
+      uint64_t         b;                                                                     \
+      string           s;                                                                     \
+      vector<uint8_t>  v;                                                                     \
+      uint64_t         c;                                                                     \
+      int32_t          d;                                                                     \
+   };                                                                                         \
+   EOS_TYPES_REFLECT_STRUCT( name, (k)(a)(b)(s)(v)(c)(d), ((k, asc)) )
+
+// Key shapes (always the first index of a table)
+#define BENCH_KEY_u64       (( uint64_t,         u_asc,  ({0})   ))
+#define BENCH_KEY_composite (( bench_pair,       u_asc,  ({1,2}) ))
+#define BENCH_KEY_string    (( string,           nu_asc, ({3})   ))
+#define BENCH_KEY_vector    (( vector<uint8_t>,  nu_asc, ({4})   ))
+#define BENCH_KEY_desc      (( uint64_t,         u_desc, ({0})   ))
+
+// Additional indices
+#define BENCH_EXTRA_1
+#define BENCH_EXTRA_3 (( uint32_t, nu_asc, ({1}) ))(( uint64_t, nu_desc, ({5}) ))
+#define BENCH_EXTRA_6 BENCH_EXTRA_3 (( int32_t, nu_asc, ({6}) ))(( string, nu_desc, ({3}) ))(( uint64_t, nu_asc, ({2}) ))
+
+#define BENCH_TABLE( shape, num_indices )                                                     \
+   BENCH_ROW( row_##shape##_##num_indices )                                                   \
+   EOS_TYPES_CREATE_TABLE( row_##shape##_##num_indices, BENCH_KEY_##shape BENCH_EXTRA_##num_indices )
+
+BENCH_TABLE( u64, 1 )       BENCH_TABLE( u64, 3 )       BENCH_TABLE( u64, 6 )
+BENCH_TABLE( composite, 1 ) BENCH_TABLE( composite, 3 ) BENCH_TABLE( composite, 6 )
+BENCH_TABLE( string, 1 )    BENCH_TABLE( string, 3 )    BENCH_TABLE( string, 6 )
+BENCH_TABLE( vector, 1 )    BENCH_TABLE( vector, 3 )    BENCH_TABLE( vector, 6 )
+BENCH_TABLE( desc, 1 )      BENCH_TABLE( desc, 3 )      BENCH_TABLE( desc, 6 )
+
+struct table_bench_types;
+EOS_TYPES_REGISTER_TYPES( table_bench_types, (row_u64_1)(row_u64_3)(row_u64_6)
+                                             (row_composite_1)(row_composite_3)(row_composite_6)
+                                             (row_string_1)(row_string_3)(row_string_6)
+                                             (row_vector_1)(row_vector_3)(row_vector_6)
+                                             (row_desc_1)(row_desc_3)(row_desc_6) )
+
+using namespace eos::types;
+using namespace eos::table;
+
+namespace {
+
+   enum class key_shape { u64, composite, string, vector, desc };
+
+   const char* shape_names[] = { "u64", "composite", "string", "vector", "desc" };
+
+   uint64_t mix(uint64_t x) // splitmix64 finalizer, which is a bijection
+   {
+      x += 0x9E3779B97F4A7C15ull;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+      return x ^ (x >> 31);
+   }
+
+   // The contents of a row are a function of a seed u. Distinct seeds give distinct keys for every unique key shape.
+   template<typename Row>
+   Row make_row(uint64_t u)
+   {
+      static const char digits[] = "0123456789abcdef";
+
+      auto h = mix(u);
+      Row row;
+      row.k = h;
+      row.a = static_cast<uint32_t>(h % 4096);
+      row.b = u * 0x9E3779B97F4A7C15ull;
+      row.s = "eosio.account.";
+      for( int i = 0; i < 6; ++i )
+         row.s.push_back(digits[(h >> (4 * i)) & 0xF]);
+      auto len = 1 + (h >> 32) % 6;
+      for( uint64_t i = 0; i < len; ++i )
+         row.v.push_back(static_cast<uint8_t>(mix(u + i) % 16));
+      row.c = (h >> 16) % 1000;
+      row.d = static_cast<int32_t>(h >> 40);
+      return row;
+   }
+
+   template<typename Row>
+   raw_region make_key(serialization_region& r, key_shape shape, type_id key_tid, const Row& row)
+   {
+      switch( shape )
+      {
+         case key_shape::u64:
+         case key_shape::desc:
+            r.write_type(row.k, key_tid);
+            break;
+         case key_shape::composite:
+            r.write_type(bench_pair{row.a, row.b}, key_tid);
+            break;
+         case key_shape::string:
+            r.write_type(row.s, key_tid);
+            break;
+         case key_shape::vector:
+            r.write_type(row.v, key_tid);
+            break;
+      }
+      return r.move_raw_region();
+   }
+
+   using bench_clock = std::chrono::steady_clock;
+
+   class recorder
+   {
+   public:
+
+      recorder(const char* engine, key_shape shape, int num_indices, size_t num_rows)
+         : engine(engine), shape(shape), num_indices(num_indices), num_rows(num_rows)
+      {}
+
+      // Times f(i) for every i in [0, n) and prints the throughput and the latency percentiles of the calls.
+      template<typename F>
+      void run(const char* op, size_t n, F&& f)
+      {
+         vector<uint64_t> latencies(n);
+         auto start = bench_clock::now();
+         for( size_t i = 0; i < n; ++i )
+         {
+            auto t0 = bench_clock::now();
+            f(i);
+            latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - t0).count();
+         }
+         double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+         print(op, n, seconds, latencies);
+      }
+
+      static void print_header()
+      {
+         std::cout << std::left << std::setw(8) << "engine" << std::setw(10) << "shape" << std::right << std::setw(8) << "indices"
+                   << std::setw(10) << "rows" << "  " << std::left << std::setw(10) << "op" << std::right << std::setw(14) << "ops/s"
+                   << std::setw(10) << "p50(ns)" << std::setw(10) << "p90(ns)" << std::setw(10) << "p99(ns)" << std::setw(12) << "max(ns)" << std::endl;
+      }
+
+   private:
+
+      void print(const char* op, size_t n, double seconds, vector<uint64_t>& latencies)const
+      {
+         std::sort(latencies.begin(), latencies.end());
+         auto percentile = [&](double p) -> uint64_t
+         {
+            if( latencies.empty() )
+               return 0;
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+         };
+
+         std::cout << std::left << std::setw(8) << engine << std::setw(10) << shape_names[static_cast<int>(shape)] << std::right
+                   << std::setw(8) << num_indices << std::setw(10) << num_rows << "  " << std::left << std::setw(10) << op << std::right
+                   << std::setw(14) << std::fixed << std::setprecision(0) << (seconds > 0 ? n / seconds : 0.0)
+                   << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.9) << std::setw(10) << percentile(0.99)
+                   << std::setw(12) << (latencies.empty() ? 0 : latencies.back()) << std::endl;
+      }
+
+      const char* engine;
+      key_shape   shape;
+      int         num_indices;
+      size_t      num_rows;
+   };
+
+   struct bench_options
+   {
+      size_t   num_rows = 100000;
+      uint64_t seed     = 1;
+   };
+
+   // Data shared by all engines for one table: the rows to insert (in a shuffled id order), the replacement data for modifies,
+   // the keys of existing rows for point lookups and keys of rows not in the table for lower_bound.
+   struct bench_data
+   {
+      vector<dynamic_object> rows;
+      vector<uint64_t>       modify_ids;
+      vector<raw_region>     modify_data;
+      vector<raw_region>     present_keys;
+      vector<raw_region>     absent_keys;
+      vector<uint64_t>       erase_ids;
+   };
+
+   template<typename Row>
+   bench_data make_bench_data(serialization_region& r, const types_manager& tm, type_id::index_t tbl, type_id row_tid, key_shape shape,
+                              const bench_options& opts)
+   {
+      auto key_tid = tm.get_table_index(tbl, 0).get_key_type();
+      std::mt19937_64 rng(opts.seed);
+      auto n = opts.num_rows;
+
+      bench_data d;
+
+      vector<uint64_t> ids(n);
+      for( size_t i = 0; i < n; ++i )
+         ids[i] = i;
+      std::shuffle(ids.begin(), ids.end(), rng);
+
+      d.rows.reserve(n);
+      for( auto id : ids )
+      {
+         r.write_type(make_row<Row>(id), row_tid);
+         d.rows.push_back(dynamic_object{id, r.move_raw_region()});
+      }
+
+      // Rows are modified to new seeds (beyond those of the inserted rows), so that their keys stay unique.
+      auto num_modifies = n / 2;
+      for( size_t i = 0; i < num_modifies; ++i )
+      {
+         d.modify_ids.push_back(rng() % n);
+         r.write_type(make_row<Row>(n + i), row_tid);
+         d.modify_data.push_back(r.move_raw_region());
+      }
+
+      // Keys looked up after the modifies, so they are built from the final contents of the rows.
+      vector<uint64_t> seeds(n);
+      for( size_t i = 0; i < n; ++i )
+         seeds[i] = i;
+      for( size_t i = 0; i < num_modifies; ++i )
+         seeds[d.modify_ids[i]] = n + i;
+
+      for( size_t i = 0; i < n; ++i )
+      {
+         d.present_keys.push_back(make_key(r, shape, key_tid, make_row<Row>(seeds[rng() % n])));
+         d.absent_keys.push_back(make_key(r, shape, key_tid, make_row<Row>(n + num_modifies + i)));
+      }
+
+      d.erase_ids = ids;
+      std::shuffle(d.erase_ids.begin(), d.erase_ids.end(), rng);
+      return d;
+   }
+
+   const size_t num_scans = 5;
+
+   template<uint8_t NumIndices> struct bmi_table;
+   template<> struct bmi_table<1> { using type = dynamic_table_1; };
+   template<> struct bmi_table<3> { using type = dynamic_table_3; };
+   template<> struct bmi_table<6> { using type = dynamic_table_6; };
+
+   template<typename Table>
+   void bench_bmi(const char* engine, const typename Table::ctor_args_list& args, const types_manager& tm, type_id::index_t tbl, key_shape shape,
+                  bench_data d)
+   {
+      Table table(args);
+      const auto& index = table.template get<1>();
+      dynamic_key_compare key_compare(tm.get_table_index(tbl, 0));
+      recorder rec(engine, shape, tm.get_num_indices_in_table(tbl), d.rows.size());
+      size_t found = 0;
+
+      rec.run("insert", d.rows.size(), [&](size_t i) { table.insert(std::move(d.rows[i])); });
+
+      rec.run("modify", d.modify_ids.size(), [&](size_t i)
+      {
+         auto itr = table.find(d.modify_ids[i]);
+         raw_region new_data(std::move(d.modify_data[i]));
+         table.modify(itr, [&](dynamic_object& o) { std::swap(o.data, new_data); }, [&](dynamic_object& o) { std::swap(o.data, new_data); });
+      });
+
+      rec.run("find", d.present_keys.size(), [&](size_t i)
+      {
+         dynamic_key k(d.present_keys[i]);
+         auto itr = index.lower_bound(k, key_compare);
+         found += (itr != index.end() && !key_compare(k, *itr));
+      });
+
+      rec.run("lower_bnd", d.absent_keys.size(), [&](size_t i)
+      {
+         found += (index.lower_bound(dynamic_key(d.absent_keys[i]), key_compare) != index.end());
+      });
+
+      rec.run("scan", num_scans, [&](size_t)
+      {
+         for( const auto& o : index )
+            found += (o.id == 0);
+      });
+
+      rec.run("erase", d.erase_ids.size(), [&](size_t i) { table.erase(d.erase_ids[i]); });
+
+      if( found < d.present_keys.size() || !table.empty() )
+         std::cerr << "Unexpected results in " << engine << " benchmark" << std::endl;
+   }
+
+   template<class Index>
+   void bench_dynamic_table(const char* engine, index_kind kind, const types_manager& tm, type_id::index_t tbl, key_shape shape, bench_data d)
+   {
+      dynamic_table table(tm, tbl, kind);
+      recorder rec(engine, shape, table.get_num_indices(), d.rows.size());
+      size_t found = 0;
+
+      rec.run("insert", d.rows.size(), [&](size_t i) { table.insert(std::move(d.rows[i])); });
+
+      rec.run("modify", d.modify_ids.size(), [&](size_t i)
+      {
+         table.modify(table.find(d.modify_ids[i]), std::move(d.modify_data[i]));
+      });
+
+      const auto& index = table.get_index<Index>(0);
+
+      rec.run("find", d.present_keys.size(), [&](size_t i)
+      {
+         found += (index.find(dynamic_key(d.present_keys[i])) != index.end());
+      });
+
+      rec.run("lower_bnd", d.absent_keys.size(), [&](size_t i)
+      {
+         found += (index.lower_bound(dynamic_key(d.absent_keys[i])) != index.end());
+      });
+
+      rec.run("scan", num_scans, [&](size_t)
+      {
+         for( const auto& o : index )
+            found += (o.id == 0);
+      });
+
+      rec.run("erase", d.erase_ids.size(), [&](size_t i) { table.erase(d.erase_ids[i]); });
+
+      if( found < d.present_keys.size() || !table.empty() )
+         std::cerr << "Unexpected results in " << engine << " benchmark" << std::endl;
+   }
+
+   // With EOS_TYPES_COMPARE_STATS, prints the comparison stats gathered by the engine that just ran, and resets them for the next one.
+   void dump_compare_stats()
+   {
+#ifdef EOS_TYPES_COMPARE_STATS
+      print_compare_stats(std::cout);
+      reset_compare_stats();
+#endif
+   }
+
+   template<typename Row, uint8_t NumIndices>
+   void bench_table(const types_manager& tm, const full_types_manager& ftm, key_shape shape, const vector<string>& engines, const bench_options& opts)
+   {
+      serialization_region r(ftm);
+      auto tbl     = tm.get_table(reflector<Row>::name());
+      auto row_tid = type_id::make_struct(ftm.get_struct_index(reflector<Row>::name()));
+      auto d       = make_bench_data<Row>(r, tm, tbl, row_tid, shape, opts);
+
+      auto copy_data = [&]()
+      {
+         bench_data c;
+         for( const auto& o : d.rows )
+            c.rows.push_back(dynamic_object{o.id, o.data});
+         c.modify_ids   = d.modify_ids;
+         c.modify_data  = d.modify_data;
+         c.present_keys = d.present_keys;
+         c.absent_keys  = d.absent_keys;
+         c.erase_ids    = d.erase_ids;
+         return c;
+      };
+
+      auto selected = [&](const char* engine)
+      {
+         return std::find(engines.begin(), engines.end(), engine) != engines.end();
+      };
+
+      dump_compare_stats(); // Discards the comparisons made while generating the data
+
+      if( selected("bmi") )
+      {
+         bench_bmi<typename bmi_table<NumIndices>::type>("bmi", make_dynamic_table_ctor_args_list<NumIndices>(tm, tbl), tm, tbl, shape, copy_data());
+         dump_compare_stats();
+      }
+      if( selected("static") )
+      {
+         bench_bmi<static_dynamic_table<Row>>("static", make_static_dynamic_table_ctor_args_list<Row>(tm, tbl), tm, tbl, shape, copy_data());
+         dump_compare_stats();
+      }
+      if( selected("ordered") )
+      {
+         bench_dynamic_table<ordered_index>("ordered", index_kind::ordered, tm, tbl, shape, copy_data());
+         dump_compare_stats();
+      }
+      if( selected("btree") )
+      {
+         bench_dynamic_table<btree_index>("btree", index_kind::btree, tm, tbl, shape, copy_data());
+         dump_compare_stats();
+      }
+   }
+
+   template<uint8_t NumIndices, typename U64, typename Composite, typename String, typename Vector, typename Desc>
+   void bench_shapes(const types_manager& tm, const full_types_manager& ftm, const vector<key_shape>& shapes, const vector<string>& engines,
+                     const bench_options& opts)
+   {
+      for( auto shape : shapes )
+      {
+         switch( shape )
+         {
+            case key_shape::u64:       bench_table<U64,       NumIndices>(tm, ftm, shape, engines, opts); break;
+            case key_shape::composite: bench_table<Composite, NumIndices>(tm, ftm, shape, engines, opts); break;
+            case key_shape::string:    bench_table<String,    NumIndices>(tm, ftm, shape, engines, opts); break;
+            case key_shape::vector:    bench_table<Vector,    NumIndices>(tm, ftm, shape, engines, opts); break;
+            case key_shape::desc:      bench_table<Desc,      NumIndices>(tm, ftm, shape, engines, opts); break;
+         }
+      }
+   }
+
+   [[noreturn]] void usage(const char* program)
+   {
+      std::cerr << "Usage: " << program << " [--rows N] [--indices 1|3|6] [--shape all|u64|composite|string|vector|desc]"
+                << " [--engine all|bmi|static|ordered|btree] [--seed S]" << std::endl;
+      std::exit(1);
+   }
+
+}
+
+int main(int argc, char** argv)
+{
+   bench_options     opts;
+   int               num_indices = 3;
+   vector<key_shape> shapes      = { key_shape::u64, key_shape::composite, key_shape::string, key_shape::vector, key_shape::desc };
+   vector<string>    engines     = { "bmi", "static", "ordered", "btree" };
+
+   for( int i = 1; i < argc; ++i )
+   {
+      string arg = argv[i];
+      if( i + 1 >= argc )
+         usage(argv[0]);
+      string value = argv[++i];
+
+      if( arg == "--rows" )
+         opts.num_rows = std::strtoull(value.c_str(), nullptr, 10);
+      else if( arg == "--seed" )
+         opts.seed = std::strtoull(value.c_str(), nullptr, 10);
+      else if( arg == "--indices" )
+      {
+         num_indices = std::atoi(value.c_str());
+         if( num_indices != 1 && num_indices != 3 && num_indices != 6 )
+            usage(argv[0]);
+      }
+      else if( arg == "--shape" )
+      {
+         if( value == "all" )
+            continue;
+         auto itr = std::find_if(std::begin(shape_names), std::end(shape_names), [&](const char* name) { return value == name; });
+         if( itr == std::end(shape_names) )
+            usage(argv[0]);
+         shapes = { static_cast<key_shape>(itr - std::begin(shape_names)) };
+      }
+      else if( arg == "--engine" )
+      {
+         if( value == "all" )
+            continue;
+         if( value != "bmi" && value != "static" && value != "ordered" && value != "btree" )
+            usage(argv[0]);
+         engines = { value };
+      }
+      else
+         usage(argv[0]);
+   }
+
+   auto ac = types_initializer<table_bench_types>::init();
+   types_constructor tc(ac.get_abi());
+   auto types_managers = tc.destructively_extract_types_managers();
+   const auto& tm  = types_managers.first;
+   const auto& ftm = types_managers.second;
+
+   recorder::print_header();
+
+   switch( num_indices )
+   {
+      case 1: bench_shapes<1, row_u64_1, row_composite_1, row_string_1, row_vector_1, row_desc_1>(tm, ftm, shapes, engines, opts); break;
+      case 3: bench_shapes<3, row_u64_3, row_composite_3, row_string_3, row_vector_3, row_desc_3>(tm, ftm, shapes, engines, opts); break;
+      case 6: bench_shapes<6, row_u64_6, row_composite_6, row_string_6, row_vector_6, row_desc_6>(tm, ftm, shapes, engines, opts); break;
+   }
+
+   return 0;
+}
@@ -0,0 +1,612 @@
+// Checks the behavior of dynamic_table, on both engines of ordered indices, and of static_dynamic_table.
+// Prints each check and exits with a non-zero status if any of them fails.
+
+#include "test_checks.hpp"
+
+#include <eos/eoslib/serialization_region.hpp>
+#include <eos/types/abi_constructor.hpp>
+#include <eos/types/types_constructor.hpp>
+#include <eos/types/types_manager.hpp>
+#include <eos/eoslib/full_types_manager.hpp>
+#include <eos/types/reflect.hpp>
+#include <eos/table/dynamic_table.hpp>
+#include <eos/table/static_object_compare.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+
+using std::vector;
+using std::string;
+
+using eos::types::rational;
+
+struct row
+{
+   uint64_t k;
+   int32_t  a;
+   string   s;
+   uint32_t b;
+   int64_t  c;
+   uint16_t d;
+   rational r;
+};
+
+struct priced
+{
+   uint64_t k;
+   rational price;
+};
+
+struct pair_key
+{
+   uint32_t a;
+   uint64_t b;
+};
+
+struct named_key
+{
+   string   s;
+   uint64_t b;
+};
+
+struct keyed
+{
+   uint64_t k;
+   uint32_t a;
+   uint64_t b;
+   string   s;
+};
+
+struct mixed_key
+{
+   uint32_t a;
+   int64_t  c;
+};
+
+// Same layout, for tables of mixed whose indices do not match its reflection.
+#define MIXED_ROW( name ) \
+   struct name            \
+   {                      \
+      uint64_t k;         \
+      uint32_t a;         \
+      string   s;         \
+      int64_t  c;         \
+   };
+
+MIXED_ROW( mixed )
+MIXED_ROW( mixed_flipped )
+MIXED_ROW( mixed_retyped )
+
+EOS_TYPES_REFLECT_STRUCT( row,           (k)(a)(s)(b)(c)(d)(r), ((k, asc)) )
+EOS_TYPES_REFLECT_STRUCT( priced,        (k)(price),            ((k, asc)) )
+EOS_TYPES_REFLECT_STRUCT( pair_key,      (a)(b),                ((a, asc))((b, asc)) )
+EOS_TYPES_REFLECT_STRUCT( named_key,     (s)(b),                ((s, asc))((b, desc)) )
+EOS_TYPES_REFLECT_STRUCT( keyed,         (k)(a)(b)(s),          ((k, asc)) )
+EOS_TYPES_REFLECT_STRUCT( mixed_key,     (a)(c),                ((a, asc))((c, desc)) )
+EOS_TYPES_REFLECT_STRUCT( mixed,         (k)(a)(s)(c),          ((k, asc)) )
+EOS_TYPES_REFLECT_STRUCT( mixed_flipped, (k)(a)(s)(c),          ((k, asc)) )
+EOS_TYPES_REFLECT_STRUCT( mixed_retyped, (k)(a)(s)(c),          ((k, asc)) )
+
+// Eleven indices, more than the nine of dynamic_table_N.
+EOS_TYPES_CREATE_TABLE( row,
+                        (( uint64_t, u_asc,   ({0}) ))
+                        (( int32_t,  nu_asc,  ({1}) ))
+                        (( string,   nu_desc, ({2}) ))
+                        (( uint32_t, nu_asc,  ({3}) ))
+                        (( int64_t,  nu_desc, ({4}) ))
+                        (( uint16_t, nu_asc,  ({5}) ))
+                        (( rational, nu_asc,  ({6}) ))
+                        (( uint64_t, u_hash,  ({0}) ))
+                        (( string,   nu_asc,  ({2}) ))
+                        (( int32_t,  nu_desc, ({1}) ))
+                        (( uint64_t, u_desc,  ({0}) ))
+                      )
+
+EOS_TYPES_CREATE_TABLE( priced, (( rational, u_hash, ({1}) )) )
+
+// Composite keys: fixed-size ones, which ordered indices cache, and ones with a string, which they abbreviate.
+EOS_TYPES_CREATE_TABLE( keyed,
+                        (( pair_key,  nu_asc, ({1,2}) ))
+                        (( named_key, nu_asc, ({3,2}) ))
+                        (( pair_key,  u_hash, ({1,2}) ))
+                      )
+
+// Ascending and descending keys of integers, strings and structs mixing both orders, all of which static_object_compare specializes.
+EOS_TYPES_CREATE_TABLE( mixed,
+                        (( uint64_t,  u_asc,   ({0})   ))
+                        (( mixed_key, nu_desc, ({1,3}) ))
+                        (( string,    nu_desc, ({2})   ))
+                        (( int64_t,   nu_asc,  ({3})   ))
+                      )
+
+EOS_TYPES_CREATE_TABLE( mixed_flipped, // Index 1 in the other order
+                        (( uint64_t,  u_asc,   ({0})   ))
+                        (( mixed_key, nu_asc,  ({1,3}) ))
+                        (( string,    nu_desc, ({2})   ))
+                        (( int64_t,   nu_asc,  ({3})   ))
+                      )
+
+EOS_TYPES_CREATE_TABLE( mixed_retyped, // Index 3 on a member of another type
+                        (( uint64_t,  u_asc,   ({0})   ))
+                        (( mixed_key, nu_desc, ({1,3}) ))
+                        (( string,    nu_desc, ({2})   ))
+                        (( uint32_t,  nu_asc,  ({1})   ))
+                      )
+
+struct table_test2_types;
+EOS_TYPES_REGISTER_TYPES( table_test2_types, (row)(priced)(keyed)(mixed)(mixed_flipped)(mixed_retyped) )
+
+using namespace eos::types;
+using namespace eos::table;
+using test_checks::check;
+using test_checks::throws;
+
+namespace {
+
+   // Type managers and serialization of the rows shared by the groups of checks below.
+   struct fixture
+   {
+      fixture(const types_manager& tm, const full_types_manager& ftm)
+         : tm(tm), ftm(ftm), r(ftm), rng(7)
+      {}
+
+      template<typename T>
+      raw_region serialize(const T& v)
+      {
+         r.write_type(v, type_id::make_struct(ftm.get_struct_index(reflector<T>::name())));
+         return r.move_raw_region();
+      }
+
+      dynamic_object make_row(uint64_t k)
+      {
+         row x{ k, static_cast<int32_t>(rng() % 100) - 50, string(rng() % 12, static_cast<char>('a' + rng() % 4)),
+                static_cast<uint32_t>(rng() % 1000), static_cast<int64_t>(rng() % 2000) - 1000, static_cast<uint16_t>(rng() % 10),
+                rational(static_cast<int64_t>(rng() % 9) - 4, 1 + rng() % 4) };
+         return dynamic_object{ k, serialize(x) };
+      }
+
+      const types_manager&      tm;
+      const full_types_manager& ftm;
+      serialization_region      r;
+      std::mt19937_64           rng;
+   };
+
+   string engine_name(index_kind kind)
+   {
+      return (kind == index_kind::btree ? "btree: " : "ordered: ");
+   }
+
+   template<class Index>
+   bool is_sorted_index(const dynamic_table& t, uint8_t index_seq_num)
+   {
+      auto ti = t.get_types_manager().get_table_index(t.get_table_index(), index_seq_num);
+      dynamic_object_compare comp(ti);
+      const auto& index = t.get_index<Index>(index_seq_num);
+      size_t n = 0;
+      const dynamic_object* prev = nullptr;
+      for( const auto& o : index )
+      {
+         if( prev != nullptr && (comp(o, *prev) || (ti.is_unique() && !comp(*prev, o))) )
+            return false;
+         prev = &o;
+         ++n;
+      }
+      return n == t.size();
+   }
+
+   // Whether every index holds every object of t, and the ordered ones in order.
+   bool is_consistent(const dynamic_table& t)
+   {
+      for( uint8_t i = 0; i < t.get_num_indices(); ++i )
+      {
+         const auto& index = t.get_index(i);
+         if( index.size() != t.size() )
+            return false;
+         if( index.get_kind() == index_kind::ordered && !is_sorted_index<ordered_index>(t, i) )
+            return false;
+         if( index.get_kind() == index_kind::btree && !is_sorted_index<btree_index>(t, i) )
+            return false;
+      }
+      return true;
+   }
+
+   std::map<uint64_t, vector<byte>> contents(const dynamic_table& t)
+   {
+      std::map<uint64_t, vector<byte>> m;
+      for( const auto& o : t )
+      {
+         auto d = o.data.get_raw_data();
+         m[o.id].assign(d.begin(), d.end());
+      }
+      return m;
+   }
+
+   vector<char> read_file(const string& path)
+   {
+      std::ifstream in(path, std::ios::binary);
+      return vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+   }
+
+   void write_file(const string& path, const vector<char>& data)
+   {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(data.data(), data.size());
+   }
+
+   // Inserting, modifying and erasing with more indices than dynamic_table_N supports.
+   void check_many_indices(fixture& fx, index_kind kind)
+   {
+      auto engine = engine_name(kind);
+      dynamic_table t(fx.tm, fx.tm.get_table("row"), kind);
+      check(t.get_num_indices() == 11, engine + "all indices are built");
+
+      for( uint64_t k = 0; k < 500; ++k )
+         t.insert(fx.make_row(k * 7 % 500));
+      check(t.size() == 500 && is_consistent(t), engine + "inserts keep every index in order");
+
+      auto dup = fx.make_row(1000);
+      dup.data = t.find(3)->data; // Same k as object 3, which violates the unique indices on k
+      auto res = t.insert(std::move(dup));
+      check(!res.second && res.first->id == 3 && t.size() == 500 && is_consistent(t), engine + "unique violation leaves the table unchanged");
+
+      check(t.modify(t.find(10), fx.make_row(10).data) && is_consistent(t), engine + "modify moves the object within the indices");
+      check(!t.modify(t.find(11), t.find(12)->data) && is_consistent(t), engine + "modify violating a unique index is rejected");
+
+      uint64_t key = 42;
+      auto found = (kind == index_kind::btree ? t.find<btree_index>(0, key) != t.get_index<btree_index>(0).end()
+                                              : t.find<ordered_index>(0, key) != t.get_index<ordered_index>(0).end());
+      check(found, engine + "native key lookup finds an object");
+
+      for( uint64_t k = 0; k < 500; k += 2 )
+         t.erase(k);
+      check(t.size() == 250 && is_consistent(t), engine + "erases keep every index in order");
+   }
+
+   // Filling a table from an unsorted batch with duplicate ids and keys.
+   void check_bulk_load(fixture& fx, index_kind kind)
+   {
+      auto engine = engine_name(kind);
+      vector<dynamic_object> batch;
+      for( uint64_t k = 0; k < 300; ++k )
+         batch.push_back(fx.make_row((k * 37) % 300)); // Not in id order
+      batch.push_back(fx.make_row(5));                  // Duplicate id
+      auto dup_key = fx.make_row(301);
+      dup_key.data = batch[10].data;                    // Duplicate key of the unique indices on k
+      batch.push_back(std::move(dup_key));
+
+      dynamic_table t(fx.tm, fx.tm.get_table("row"), kind);
+      auto rejections = t.bulk_load(batch);
+      check(t.size() == 300 && is_consistent(t), engine + "bulk_load sorts an unsorted batch");
+      check(rejections.size() == 2 && rejections[0].position == 300 && rejections[0].index_seq_num == -1
+            && rejections[1].position == 301 && rejections[1].index_seq_num == 0,
+            engine + "bulk_load rejects duplicate ids and keys");
+
+      bool in_order = true;
+      uint64_t prev = 0;
+      for( const auto& o : t )
+      {
+         in_order = in_order && (&o == &*t.begin() || o.id > prev);
+         prev = o.id;
+      }
+      check(in_order, engine + "bulk loaded objects are in id order");
+
+      vector<dynamic_object> more;
+      more.push_back(fx.make_row(1000));
+      check(throws([&]() { t.bulk_load(more); }) && t.size() == 300, engine + "bulk_load requires an empty table");
+   }
+
+   // Nested undo sessions, squashing the inner one into the outer one, and committing.
+   void check_undo(fixture& fx, index_kind kind)
+   {
+      auto engine = engine_name(kind);
+      dynamic_table t(fx.tm, fx.tm.get_table("row"), kind);
+      for( uint64_t k = 0; k < 100; ++k )
+         t.insert(fx.make_row(k));
+      auto original = contents(t);
+
+      {
+         auto outer = t.start_undo_session();
+         t.insert(fx.make_row(100));
+         t.modify(t.find(1), fx.make_row(1).data);
+         t.erase(2);
+         auto after_outer = contents(t);
+
+         {
+            auto inner = t.start_undo_session();
+            t.insert(fx.make_row(101));
+            t.modify(t.find(3), fx.make_row(3).data);
+            t.erase(100);
+            t.modify(t.find(1), fx.make_row(1).data);
+            check(t.get_undo_depth() == 2, engine + "sessions nest");
+         }
+         check(contents(t) == after_outer && is_consistent(t), engine + "undoing the inner session restores the state of the outer one");
+
+         {
+            auto inner = t.start_undo_session();
+            t.insert(fx.make_row(102));
+            t.erase(4);
+            inner.squash();
+         }
+         check(t.get_undo_depth() == 1 && t.find(102) != t.end() && t.find(4) == t.end(), engine + "squash keeps the changes in the outer session");
+      }
+      check(contents(t) == original && t.get_undo_depth() == 0 && is_consistent(t), engine + "undoing the outer session also undoes the squashed changes");
+
+      {
+         auto s = t.start_undo_session();
+         t.erase(5);
+         s.push();
+      }
+      t.commit();
+      check(t.find(5) == t.end() && t.get_undo_depth() == 0, engine + "committed changes are kept");
+   }
+
+   // Saving a table to an image and loading it back, and rejecting images that do not match the table.
+   void check_images(fixture& fx, index_kind kind)
+   {
+      auto engine = engine_name(kind);
+      const string path = "table_test2.img";
+
+      dynamic_table t(fx.tm, fx.tm.get_table("row"), kind);
+      for( uint64_t k = 0; k < 400; ++k )
+         t.insert(fx.make_row(k * 3));
+
+      for( bool keep_orders : {true, false} )
+      {
+         t.save(path, keep_orders);
+         for( auto load_kind : {index_kind::ordered, index_kind::btree} )
+         {
+            dynamic_table u(fx.tm, fx.tm.get_table("row"), load_kind);
+            u.load(path);
+            check(contents(u) == contents(t) && is_consistent(u),
+                  engine + (keep_orders ? "image with orders" : "image without orders") + " loads the same objects into "
+                  + (load_kind == index_kind::btree ? "a btree table" : "an ordered table"));
+         }
+      }
+
+      t.save(path);
+      auto image = read_file(path);
+
+      auto tampered = image;
+      tampered[offsetof(table_image::header, fingerprint)] ^= 1;
+      write_file(path, tampered);
+      {
+         dynamic_table u(fx.tm, fx.tm.get_table("row"), kind);
+         check(throws([&]() { u.load(path); }) && u.empty(), engine + "image with another fingerprint is rejected");
+      }
+
+      write_file(path, vector<char>(image.begin(), image.begin() + image.size() / 2));
+      {
+         dynamic_table u(fx.tm, fx.tm.get_table("row"), kind);
+         check(throws([&]() { u.load(path); }) && u.empty(), engine + "truncated image is rejected");
+      }
+
+      write_file(path, image);
+      {
+         dynamic_table u(fx.tm, fx.tm.get_table("row"), kind);
+         u.insert(fx.make_row(1));
+         check(throws([&]() { u.load(path); }) && u.size() == 1, engine + "loading requires an empty table");
+      }
+
+      std::remove(path.c_str());
+   }
+
+   // Lookups in a hashed index, and the keys it cannot hash.
+   void check_hashed(fixture& fx)
+   {
+      dynamic_table t(fx.tm, fx.tm.get_table("row"));
+      for( uint64_t k = 0; k < 100; ++k )
+         t.insert(fx.make_row(k));
+
+      auto key = [&](uint64_t k)
+      {
+         fx.r.write_type(k, type_id(type_id::builtin_uint64));
+         return fx.r.move_raw_region();
+      };
+
+      const auto& index = t.get_index<hashed_index>(7);
+      auto present = key(42);
+      auto itr = index.find(dynamic_key(present));
+      check(itr != index.end() && itr->id == 42, "hashed index finds an object by its key");
+
+      auto absent = key(100);
+      check(index.find(dynamic_key(absent)) == index.end(), "hashed index does not find an absent key");
+
+      check(throws([&]() { dynamic_table p(fx.tm, fx.tm.get_table("priced")); }), "hashed index on a rational key is rejected");
+   }
+
+   // Whether the lookups of the partial key k in index find exactly the objects with the given ids.
+   template<class Index>
+   bool finds_exactly(const Index& index, const dynamic_key& k, vector<uint64_t> ids)
+   {
+      auto range = index.equal_range(k);
+      vector<uint64_t> found;
+      for( auto itr = range.first; itr != range.second; ++itr )
+         found.push_back(itr->id);
+      std::sort(found.begin(), found.end());
+      std::sort(ids.begin(), ids.end());
+
+      auto itr = index.find(k);
+      return found == ids && index.lower_bound(k) == range.first && index.upper_bound(k) == range.second
+             && (ids.empty() ? itr == index.end() : itr == range.first);
+   }
+
+   // Lookups of composite keys given only their first member, which must find every object with that member, and whose lower bound for
+   // an absent member must be the first object past it.
+   template<class Index>
+   void check_partial_keys(fixture& fx, index_kind kind)
+   {
+      auto engine = engine_name(kind);
+      dynamic_table t(fx.tm, fx.tm.get_table("keyed"), kind);
+      vector<keyed> rows;
+      for( uint64_t k = 0; k < 3000; ++k ) // Enough for a btree_index to have inner nodes
+      {
+         auto a = static_cast<uint32_t>(fx.rng() % 8);
+         auto c = static_cast<char>('a' + fx.rng() % 4);
+         keyed x{ k, (a == 3 ? 4 : a), k, string(20, 'x') + (c == 'b' ? 'c' : c) }; // No a of 3 nor s ending in 'b'
+         rows.push_back(x);
+         t.insert(dynamic_object{ k, fx.serialize(x) });
+      }
+
+      const auto& by_pair = t.get_index<Index>(0);
+      const auto& by_name = t.get_index<Index>(1);
+      if( kind == index_kind::ordered )
+      {
+         check(t.get_index<ordered_index>(0).is_caching_keys() && t.get_index<ordered_index>(1).is_abbreviating_keys(),
+               engine + "composite keys are cached and abbreviated");
+      }
+
+      bool all_found = true;
+      for( uint32_t a = 0; a < 9; ++a )
+      {
+         vector<uint64_t> ids;
+         for( const auto& x : rows )
+            if( x.a == a )
+               ids.push_back(x.k);
+         auto key = fx.serialize(pair_key{a, 0});
+         all_found = all_found && finds_exactly(by_pair, dynamic_key(key, 1), ids);
+      }
+      check(all_found, engine + "partial fixed-size key finds every object with its first member");
+
+      all_found = true;
+      for( char c = 'a'; c <= 'e'; ++c )
+      {
+         vector<uint64_t> ids;
+         auto s = string(20, 'x') + c;
+         for( const auto& x : rows )
+            if( x.s == s )
+               ids.push_back(x.k);
+         auto key = fx.serialize(named_key{s, 0});
+         all_found = all_found && finds_exactly(by_name, dynamic_key(key, 1), ids);
+      }
+      check(all_found, engine + "partial key with a string finds every object with its first member");
+
+      auto absent_pair = fx.serialize(pair_key{3, 0});
+      auto next_pair   = fx.serialize(pair_key{4, 0});
+      auto absent_name = fx.serialize(named_key{string(20, 'x') + 'b', 0});
+      auto next_name   = fx.serialize(named_key{string(20, 'x') + 'c', 0});
+      check(by_pair.lower_bound(dynamic_key(absent_pair, 1)) == by_pair.lower_bound(dynamic_key(next_pair, 1))
+            && by_name.lower_bound(dynamic_key(absent_name, 1)) == by_name.lower_bound(dynamic_key(next_name, 1)),
+            engine + "lower bound of an absent partial key is the first object past it");
+
+      auto native = t.equal_range<Index>(0, std::make_tuple(uint32_t(4)));
+      auto bound  = by_pair.equal_range(dynamic_key(next_pair, 1));
+      check(native.first == bound.first && native.second == bound.second, engine + "partial native key finds the same objects");
+
+      const auto& by_hash = t.get_index<hashed_index>(2);
+      auto full = fx.serialize(pair_key{rows[7].a, rows[7].b});
+      check(by_hash.find(dynamic_key(full)) != by_hash.end() && throws([&]() { by_hash.find(dynamic_key(full, 1)); }),
+            engine + "hashed index rejects a partial key");
+   }
+
+   template<class Lhs, class Rhs>
+   bool same_order(const Lhs& lhs, const Rhs& rhs)
+   {
+      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                        [](const dynamic_object& l, const dynamic_object& r) { return l.id == r.id; });
+   }
+
+   // Comparators specialized at compile time, which must order objects exactly like dynamic_object_compare, and must refuse a table
+   // whose indices do not match the reflection they were generated from.
+   void check_static_compare(fixture& fx)
+   {
+      using indices = table_reflector<mixed>::indices;
+      static_assert( static_object_compare<std::tuple_element_t<1, indices>>::is_supported::value, "Struct key must be specialized" );
+      static_assert( static_object_compare<std::tuple_element_t<2, indices>>::is_supported::value, "String key must be specialized" );
+
+      auto tbl = fx.tm.get_table("mixed");
+      static_dynamic_table<mixed> st(make_static_dynamic_table_ctor_args_list<mixed>(fx.tm, tbl));
+      dynamic_table_4             dt(make_dynamic_table_ctor_args_list<4>(fx.tm, tbl));
+
+      bool all_inserted = true;
+      for( uint64_t k = 0; k < 2000; ++k )
+      {
+         mixed x{ k, static_cast<uint32_t>(fx.rng() % 5), string(fx.rng() % 6, static_cast<char>('a' + fx.rng() % 3)),
+                  static_cast<int64_t>(fx.rng() % 11) - 5 };
+         dynamic_object o{ (k * 7919) % 2000, fx.serialize(x) };
+         all_inserted = all_inserted && st.insert(o).second && dt.insert(o).second;
+      }
+      for( uint64_t id = 0; id < 2000; id += 3 )
+      {
+         st.erase(id);
+         dt.erase(id);
+      }
+      check(all_inserted && st.size() == dt.size(), "static: same objects as dynamic_table_N");
+      check(same_order(st.get<1>(), dt.get<1>()), "static: unique ascending integer key is ordered the same");
+      check(same_order(st.get<2>(), dt.get<2>()), "static: descending struct key with ascending and descending members is ordered the same");
+      check(same_order(st.get<3>(), dt.get<3>()), "static: descending string key is ordered the same");
+      check(same_order(st.get<4>(), dt.get<4>()), "static: ascending signed integer key is ordered the same");
+
+      check(throws([&]() { make_static_dynamic_table_ctor_args_list<mixed>(fx.tm, fx.tm.get_table("mixed_flipped")); }),
+            "static: index in another order is rejected");
+      check(throws([&]() { make_static_dynamic_table_ctor_args_list<mixed>(fx.tm, fx.tm.get_table("mixed_retyped")); }),
+            "static: index on a member of another type is rejected");
+      check(throws([&]() { make_static_dynamic_table_ctor_args_list<mixed>(fx.tm, fx.tm.get_table("keyed")); }),
+            "static: table with another number of indices is rejected");
+   }
+
+   // Splitting leaves and inner nodes of the B+tree, and merging them while erasing everything.
+   void check_btree_splits(fixture& fx)
+   {
+      dynamic_table t(fx.tm, fx.tm.get_table("row"), index_kind::btree);
+      const uint64_t n = 20000; // More than btree_index::leaf_capacity * btree_index::inner_capacity entries, so inner nodes split too
+      vector<uint64_t> ids(n);
+      for( uint64_t k = 0; k < n; ++k )
+         ids[k] = k;
+      std::shuffle(ids.begin(), ids.end(), fx.rng);
+      for( auto k : ids )
+         t.insert(fx.make_row(k));
+
+      auto usage = t.get_index(0).get_memory_usage();
+      check(usage.nodes > n / btree_index::leaf_capacity + btree_index::inner_capacity, "btree: leaves and inner nodes split");
+      check(is_consistent(t), "btree: split tree keeps every index in order");
+
+      std::shuffle(ids.begin(), ids.end(), fx.rng);
+      bool consistent = true;
+      for( size_t i = 0; i < ids.size(); ++i )
+      {
+         t.erase(ids[i]);
+         if( i == ids.size() / 2 )
+            consistent = is_consistent(t);
+      }
+      check(consistent, "btree: tree stays in order while erasing");
+
+      const auto& index = t.get_index<btree_index>(0);
+      check(t.empty() && index.size() == 0 && index.begin() == index.end() && index.get_memory_usage().nodes == 1,
+            "btree: erasing everything leaves an empty tree");
+
+      t.insert(fx.make_row(1));
+      check(t.size() == 1 && is_consistent(t), "btree: emptied tree can be filled again");
+   }
+
+}
+
+int main()
+{
+   auto ac = types_initializer<table_test2_types>::init();
+   types_constructor tc(ac.get_abi());
+   auto types_managers = tc.destructively_extract_types_managers();
+   fixture fx(types_managers.first, types_managers.second);
+
+   check(fx.tm.get_num_indices_in_table(fx.tm.get_table("row")) == 11, "table has 11 indices");
+
+   for( auto kind : {index_kind::ordered, index_kind::btree} )
+   {
+      check_many_indices(fx, kind);
+      check_bulk_load(fx, kind);
+      check_undo(fx, kind);
+      check_images(fx, kind);
+   }
+   check_partial_keys<ordered_index>(fx, index_kind::ordered);
+   check_partial_keys<btree_index>(fx, index_kind::btree);
+   check_btree_splits(fx);
+   check_hashed(fx);
+   check_static_compare(fx);
+
+   return test_checks::report();
+}
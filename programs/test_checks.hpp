@@ -0,0 +1,45 @@
+#pragma once
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+// Harness shared by the test programs: every check is printed, and report() ends the program with a non-zero status if any of them failed.
+namespace test_checks {
+
+   inline int& failures()
+   {
+      static int n = 0;
+      return n;
+   }
+
+   inline void check(bool ok, const std::string& what)
+   {
+      std::cout << (ok ? "ok:     " : "FAILED: ") << what << std::endl;
+      if( !ok )
+         ++failures();
+   }
+
+   // Whether f throws an exception derived from std::exception.
+   template<typename F>
+   bool throws(F f)
+   {
+      try
+      {
+         f();
+      }
+      catch( const std::exception& )
+      {
+         return true;
+      }
+      return false;
+   }
+
+   // Exit status of the program.
+   inline int report()
+   {
+      std::cout << (failures() == 0 ? "All checks passed." : "Some checks failed.") << std::endl;
+      return (failures() == 0 ? 0 : 1);
+   }
+
+}